@@ -0,0 +1,506 @@
+/*
+ *
+ *      Print benchmark
+ *
+ *      Compares print() with printf, std::ostream, and std::format /
+ *      std::print where the standard library provides them, on the
+ *      same workloads, so print() can be judged for hot paths.
+ *
+ *      Every contestant runs against two targets that take the
+ *      terminal out of the measurement:
+ *
+ *          > devnull       /dev/null through each API's usual buffered
+ *                          file: buffered_file_sink for print(), a FILE*
+ *                          for printf and std::format, std::ofstream for
+ *                          iostream (std::cout itself would need stdout
+ *                          redirected, and the results are printed there).
+ *          > memory        a 64 KiB ring in memory: a print_sink for
+ *                          print(), fopencookie() for FILE* based APIs,
+ *                          a std::streambuf for iostream.
+ *
+ *      Before timing, a few lines are checked against their expected
+ *      text, including print() called from inside a value's own
+ *      operator<<. The exit code is 1 if any differ.
+ *
+ *      Results are printed to stdout as a single JSON document.
+ *
+ *
+ *      Building:
+ *
+ *          > g++ -std=c++17 -O2 -pthread -I.. print_bench.cpp -o print_bench
+ *
+ *          std::format is only measured with -std=c++20 (or later) on a
+ *          standard library that has it, std::print with -std=c++23.
+ *
+ *      Running:
+ *
+ *          > ./print_bench [iterations]
+ *
+ *          iterations (per workload, per contestant) defaults to 200000,
+ *          workloads on 10000 element vectors run iterations / 1000 times.
+ *
+ *
+ *      Contestants:
+ *
+ *          > print                     print(to(sink), ...)
+ *          > print_to                  print_to(buffer, capacity, ...), then fwrite()
+ *          > printf                    fprintf, loops for containers
+ *          > iostream                  operator<<, loops for containers
+ *          > std_format                std::format_to into a buffer, then fwrite()
+ *          > std_print                 std::print(FILE*, ...)
+ *
+ *      Workloads:
+ *
+ *          > scalars                   an int and a double
+ *          > strings                   a std::string and a const char*
+ *          > mixed                     strings, ints, a double and a bool
+ *          > nested                    a 4 x 4 std::vector<std::vector<int>>
+ *          > map                       a std::map<std::string, int> of 4
+ *          > vector_int                a std::vector<int> of 10000
+ *          > vector_double             a std::vector<double> of 10000
+ *
+ *          Contestants do not produce identical text: print() adds its
+ *          brackets and full-stop, and prints doubles in their shortest
+ *          round-trip form where printf and iostream use 6 digits.
+ *
+ *
+ *      Reported per contestant, workload and target:
+ *
+ *          > ns_per_call               wall-clock nanoseconds per call.
+ *          > allocs_per_call           calls to operator new per call.
+ *          > bytes_per_call            bytes written per call.
+ *          > mb_per_s                  output rate.
+ *
+ */
+
+#include    <vector>
+#include    <string>
+#include    <map>
+#include    <array>
+#include    <chrono>
+#include    <fstream>
+#include    <functional>
+#include    <cstdio>
+#include    <cstdlib>
+#include    <cstdint>
+#include    <cstring>
+#if __has_include(<format>)
+#include    <format>
+#endif
+#if __has_include(<print>)
+#include    <print>
+#endif
+
+#include    "../print.hpp"
+
+namespace
+{
+
+size_t allocations = 0;
+
+}
+
+void* operator new(size_t n)
+{
+    allocations++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+// the memory target: a ring that keeps the last 64 KiB and counts everything written to it
+struct memory_ring
+{
+    char    data[1 << 16];
+    size_t  at      = 0;
+    size_t  total   = 0;
+    void put(const char* s, size_t n)
+    {
+        total += n;
+        while (n > 0)
+        {
+            size_t k = std::min(n, sizeof(data) - at);
+            std::memcpy(data + at, s, k);
+            at = (at + k) % sizeof(data);
+            s += k; n -= k;
+        }
+    }
+};
+
+memory_ring ring;
+
+class memory_sink : public print_sink
+{
+public:
+    void write(const std::string_view* parts, size_t count) override
+    {
+        for (size_t i = 0; i < count; i++) ring.put(parts[i].data(), parts[i].size());
+    }
+};
+
+class memory_streambuf : public std::streambuf
+{
+    char buffer[4096];
+public:
+    memory_streambuf() { setp(buffer, buffer + sizeof(buffer)); }
+    int overflow(int c) override
+    {
+        sync();
+        if (c != EOF) { *pptr() = static_cast<char>(c); pbump(1); }
+        return c;
+    }
+    int sync() override
+    {
+        ring.put(pbase(), pptr() - pbase());
+        setp(buffer, buffer + sizeof(buffer));
+        return 0;
+    }
+};
+
+FILE* memory_file()
+{
+    cookie_io_functions_t io = {};
+    io.write = [](void*, const char* s, size_t n) -> ssize_t { ring.put(s, n); return n; };
+    return fopencookie(nullptr, "w", io);
+}
+
+struct target
+{
+    const char*     name;
+    print_sink&     sink;
+    FILE*           file;
+    std::ostream&   os;
+};
+
+struct inputs
+{
+    int                                 i       = 42;
+    double                              d       = 3.14159;
+    bool                                b       = true;
+    std::string                         s       = "the quick brown fox jumps over";
+    const char*                         c       = "the lazy dog";
+    std::vector<std::vector<int>>       nested  = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {13, 14, 15, 16}};
+    std::map<std::string, int>          map     = {{"alpha", 1}, {"beta", 2}, {"gamma", 3}, {"delta", 4}};
+    std::vector<int>                    ints;
+    std::vector<double>                 doubles;
+    inputs() : ints(10000), doubles(10000)
+    {
+        uint64_t x = 88172645463325252ull;
+        for (size_t k = 0; k < ints.size(); k++)
+        {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            ints[k]     = static_cast<int>(x);
+            doubles[k]  = static_cast<double>(x >> 11) / 9007199254740992.0 * 1e6;
+        }
+    }
+};
+
+// formatted output of std::format and print_to() is staged here before fwrite()
+char staging[1 << 20];
+
+struct contestant
+{
+    const char*                         name;
+    std::function<void(target&)>        call;
+};
+
+struct workload
+{
+    const char*                         name;
+    size_t                              divisor;
+    std::vector<contestant>             contestants;
+};
+
+template <typename Range>
+void printf_ints(FILE* f, const Range& r)
+{
+    std::fputc('[', f);
+    bool first = true;
+    for (int v : r) { std::fprintf(f, first ? "%d" : ", %d", v); first = false; }
+    std::fputc(']', f);
+}
+
+template <typename Range>
+void ostream_range(std::ostream& os, const Range& r)
+{
+    os << '[';
+    bool first = true;
+    for (const auto& v : r) { if (!first) os << ", "; os << v; first = false; }
+    os << ']';
+}
+
+void stage(FILE* f, const char* end)
+{
+    std::fwrite(staging, 1, end - staging, f);
+}
+
+std::vector<workload> workloads(inputs& in)
+{
+    std::vector<workload> w;
+    w.push_back({"scalars", 1, {
+        {"print",       [&](target& t) { print(to(t.sink), in.i, in.d); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.i, in.d)); }},
+        {"printf",      [&](target& t) { std::fprintf(t.file, "%d %g\n", in.i, in.d); }},
+        {"iostream",    [&](target& t) { t.os << in.i << ' ' << in.d << '\n'; }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) { stage(t.file, std::format_to(staging, "{} {}\n", in.i, in.d)); }},
+        #endif
+        #ifdef __cpp_lib_print
+        {"std_print",   [&](target& t) { std::print(t.file, "{} {}\n", in.i, in.d); }},
+        #endif
+    }});
+    w.push_back({"strings", 1, {
+        {"print",       [&](target& t) { print(to(t.sink), in.s, in.c); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.s, in.c)); }},
+        {"printf",      [&](target& t) { std::fprintf(t.file, "%s %s\n", in.s.c_str(), in.c); }},
+        {"iostream",    [&](target& t) { t.os << in.s << ' ' << in.c << '\n'; }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) { stage(t.file, std::format_to(staging, "{} {}\n", in.s, in.c)); }},
+        #endif
+        #ifdef __cpp_lib_print
+        {"std_print",   [&](target& t) { std::print(t.file, "{} {}\n", in.s, in.c); }},
+        #endif
+    }});
+    w.push_back({"mixed", 1, {
+        {"print",       [&](target& t) { print(to(t.sink), "id", in.i, "name", in.s, "score", in.d, "ok", in.b); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), "id", in.i, "name", in.s, "score", in.d, "ok", in.b)); }},
+        {"printf",      [&](target& t) { std::fprintf(t.file, "id %d name %s score %g ok %s\n", in.i, in.s.c_str(), in.d, in.b ? "true" : "false"); }},
+        {"iostream",    [&](target& t) { t.os << "id " << in.i << " name " << in.s << " score " << in.d << " ok " << std::boolalpha << in.b << '\n'; }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) { stage(t.file, std::format_to(staging, "id {} name {} score {} ok {}\n", in.i, in.s, in.d, in.b)); }},
+        #endif
+        #ifdef __cpp_lib_print
+        {"std_print",   [&](target& t) { std::print(t.file, "id {} name {} score {} ok {}\n", in.i, in.s, in.d, in.b); }},
+        #endif
+    }});
+    w.push_back({"nested", 1, {
+        {"print",       [&](target& t) { print(to(t.sink), in.nested); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.nested)); }},
+        {"printf",      [&](target& t) {
+            std::fputc('[', t.file);
+            for (size_t k = 0; k < in.nested.size(); k++) { if (k) std::fputs(", ", t.file); printf_ints(t.file, in.nested[k]); }
+            std::fputs("]\n", t.file);
+        }},
+        {"iostream",    [&](target& t) {
+            t.os << '[';
+            for (size_t k = 0; k < in.nested.size(); k++) { if (k) t.os << ", "; ostream_range(t.os, in.nested[k]); }
+            t.os << "]\n";
+        }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) {
+            char* out = staging;
+            *out++ = '[';
+            for (size_t k = 0; k < in.nested.size(); k++)
+            {
+                if (k) out = std::format_to(out, ", ");
+                *out++ = '[';
+                for (size_t j = 0; j < in.nested[k].size(); j++) out = std::format_to(out, j ? ", {}" : "{}", in.nested[k][j]);
+                *out++ = ']';
+            }
+            out = std::format_to(out, "]\n");
+            stage(t.file, out);
+        }},
+        #endif
+    }});
+    w.push_back({"map", 1, {
+        {"print",       [&](target& t) { print(to(t.sink), in.map); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.map)); }},
+        {"printf",      [&](target& t) {
+            std::fputc('{', t.file);
+            bool first = true;
+            for (const auto& kv : in.map) { std::fprintf(t.file, first ? "%s: %d" : ", %s: %d", kv.first.c_str(), kv.second); first = false; }
+            std::fputs("}\n", t.file);
+        }},
+        {"iostream",    [&](target& t) {
+            t.os << '{';
+            bool first = true;
+            for (const auto& kv : in.map) { if (!first) t.os << ", "; t.os << kv.first << ": " << kv.second; first = false; }
+            t.os << "}\n";
+        }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) {
+            char* out = staging;
+            *out++ = '{';
+            bool first = true;
+            for (const auto& kv : in.map) { out = std::format_to(out, first ? "{}: {}" : ", {}: {}", kv.first, kv.second); first = false; }
+            out = std::format_to(out, "}}\n");
+            stage(t.file, out);
+        }},
+        #endif
+    }});
+    w.push_back({"vector_int", 1000, {
+        {"print",       [&](target& t) { print(to(t.sink), in.ints); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.ints)); }},
+        {"printf",      [&](target& t) { printf_ints(t.file, in.ints); std::fputc('\n', t.file); }},
+        {"iostream",    [&](target& t) { ostream_range(t.os, in.ints); t.os << '\n'; }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) {
+            char* out = staging;
+            *out++ = '[';
+            for (size_t k = 0; k < in.ints.size(); k++) out = std::format_to(out, k ? ", {}" : "{}", in.ints[k]);
+            out = std::format_to(out, "]\n");
+            stage(t.file, out);
+        }},
+        #endif
+    }});
+    w.push_back({"vector_double", 1000, {
+        {"print",       [&](target& t) { print(to(t.sink), in.doubles); }},
+        {"print_to",    [&](target& t) { stage(t.file, staging + print_to(staging, sizeof(staging), in.doubles)); }},
+        {"printf",      [&](target& t) {
+            std::fputc('[', t.file);
+            for (size_t k = 0; k < in.doubles.size(); k++) std::fprintf(t.file, k ? ", %g" : "%g", in.doubles[k]);
+            std::fputs("]\n", t.file);
+        }},
+        {"iostream",    [&](target& t) { ostream_range(t.os, in.doubles); t.os << '\n'; }},
+        #ifdef __cpp_lib_format
+        {"std_format",  [&](target& t) {
+            char* out = staging;
+            *out++ = '[';
+            for (size_t k = 0; k < in.doubles.size(); k++) out = std::format_to(out, k ? ", {}" : "{}", in.doubles[k]);
+            out = std::format_to(out, "]\n");
+            stage(t.file, out);
+        }},
+        #endif
+    }});
+    return w;
+}
+
+struct result
+{
+    double  ns_per_call     = 0;
+    double  allocs_per_call = 0;
+    double  bytes_per_call  = 0;
+};
+
+void flush(target& t)
+{
+    t.sink.flush();
+    std::fflush(t.file);
+    t.os.flush();
+}
+
+// collects print() output for the checks
+class string_sink : public print_sink
+{
+public:
+    std::string text;
+    void write(const std::string_view* parts, size_t count) override
+    {
+        for (size_t i = 0; i < count; i++) text.append(parts[i].data(), parts[i].size());
+    }
+};
+
+string_sink checked;
+
+// logs from inside its own formatting, the nested print() must leave the outer line alone
+struct noisy
+{
+    int v;
+};
+
+std::ostream& operator<<(std::ostream& os, const noisy& n)
+{
+    print(to(checked), "log:", n.v);
+    return os << "noisy(" << n.v << ")";
+}
+
+bool check(const char* name, const std::string& got, const char* expected)
+{
+    if (got == expected) return true;
+    std::fprintf(stderr, "print_bench: %s printed \"%s\", expected \"%s\"\n", name, got.c_str(), expected);
+    return false;
+}
+
+bool checks(const inputs& in)
+{
+    bool pass = true;
+    char line[256];
+    pass = check("scalars", std::string(line, print_to(line, sizeof(line), in.i, in.d)), "42 3.14159.\n") && pass;
+    pass = check("map", std::string(line, print_to(line, sizeof(line), in.map)), "{alpha: 1, beta: 2, delta: 4, gamma: 3}.\n") && pass;
+    checked.text.clear();
+    print(to(checked), "value is", noisy{7}, "done");
+    pass = check("nested print", checked.text, "log: 7.\nvalue is noisy(7) done.\n") && pass;
+    checked.text.clear();
+    std::array<noisy, 2> values = {{{1}, {2}}};
+    print(to(checked), values);
+    pass = check("nested print in an array", checked.text, "log: 1.\nlog: 2.\n[noisy(1), noisy(2)].\n") && pass;
+    checked.text.clear();
+    std::string formatted(line, print_to(line, sizeof(line), "value is", noisy{7}));
+    pass = check("nested print from print_to", checked.text + formatted, "log: 7.\nvalue is noisy(7).\n") && pass;
+    return pass;
+}
+
+result run(const contestant& c, target& t, size_t iterations)
+{
+    size_t before = ring.total;
+    for (size_t k = 0; k < std::min<size_t>(iterations, 16); k++) c.call(t);
+    flush(t);
+    result r;
+    r.bytes_per_call = static_cast<double>(ring.total - before) / std::min<size_t>(iterations, 16);
+    size_t allocs   = allocations;
+    auto start      = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < iterations; k++) c.call(t);
+    flush(t);
+    auto stop       = std::chrono::steady_clock::now();
+    r.ns_per_call       = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+    r.allocs_per_call   = static_cast<double>(allocations - allocs) / iterations;
+    return r;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t iterations = 200000;
+    if (argc > 1) iterations = std::strtoull(argv[1], nullptr, 10);
+    if (iterations < 1000) iterations = 1000;
+
+    inputs                  in;
+    std::vector<workload>   w = workloads(in);
+
+    memory_sink             msink;
+    memory_streambuf        mbuf;
+    std::ostream            mos(&mbuf);
+    FILE*                   mfile = memory_file();
+    buffered_file_sink      dsink("/dev/null");
+    std::ofstream           dos("/dev/null");
+    FILE*                   dfile = std::fopen("/dev/null", "w");
+    if (mfile == nullptr || dfile == nullptr || !dsink.good() || !dos)
+    {
+        std::fprintf(stderr, "print_bench: cannot open targets\n");
+        return 1;
+    }
+    target targets[2] = {{"devnull", dsink, dfile, dos}, {"memory", msink, mfile, mos}};
+    bool pass = checks(in);
+
+    std::printf("{\n  \"benchmark\": \"print\",\n  \"iterations\": %zu,\n  \"workloads\": [\n", iterations);
+    for (size_t i = 0; i < w.size(); i++)
+    {
+        size_t n = iterations / w[i].divisor;
+        std::printf("    {\n      \"name\": \"%s\",\n      \"calls\": %zu,\n      \"results\": [\n", w[i].name, n);
+        for (size_t j = 0; j < w[i].contestants.size(); j++)
+        {
+            result r[2];
+            r[1] = run(w[i].contestants[j], targets[1], n);
+            r[0] = run(w[i].contestants[j], targets[0], n);
+            // the devnull run never touches the ring, its bytes are those of the memory run
+            r[0].bytes_per_call = r[1].bytes_per_call;
+            for (size_t k = 0; k < 2; k++)
+            {
+                std::printf("        {\"contestant\": \"%s\", \"target\": \"%s\", \"ns_per_call\": %.1f, \"allocs_per_call\": %.3f, "
+                            "\"bytes_per_call\": %.0f, \"mb_per_s\": %.1f}%s\n",
+                            w[i].contestants[j].name, targets[k].name, r[k].ns_per_call, r[k].allocs_per_call, r[k].bytes_per_call,
+                            r[k].bytes_per_call / r[k].ns_per_call * 1e3, j + 1 == w[i].contestants.size() && k == 1 ? "" : ",");
+            }
+        }
+        std::printf("      ]\n    }%s\n", i + 1 == w.size() ? "" : ",");
+    }
+    std::printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+    std::fclose(mfile);
+    std::fclose(dfile);
+    return pass ? 0 : 1;
+}
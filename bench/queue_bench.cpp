@@ -0,0 +1,184 @@
+/*
+ *
+ *      Queue benchmark
+ *
+ *      Measures concurrent_queue under contention against the setup it
+ *      replaces: a linked_list behind one std::mutex shared by every
+ *      thread, appending with push_back() and popping the front.
+ *
+ *      Each run starts P producer and P consumer threads at once.
+ *      Every producer pushes its own increasing sequence, consumers pop
+ *      until all items are accounted for. The run is repeated for
+ *      P = 1, 2, 4, ... up to the requested thread count.
+ *
+ *      Every run is checked: each item is popped exactly once, and the
+ *      items of one producer reach any one consumer in the order they
+ *      were pushed. The exit code is 1 if any check fails.
+ *
+ *      Results are printed to stdout as a single JSON document.
+ *
+ *
+ *      Building:
+ *
+ *          > g++ -std=c++17 -O2 -pthread -I.. queue_bench.cpp -o queue_bench
+ *
+ *      Running:
+ *
+ *          > ./queue_bench [producers] [items]
+ *
+ *          producers defaults to 32, items (per producer) to 200000.
+ *          Scaling is only visible with as many cores as threads, on
+ *          fewer cores the threads time-slice and contention is lower.
+ *
+ *
+ *      Reported per contestant and thread count:
+ *
+ *          > ns_per_item               wall-clock nanoseconds per item,
+ *                                      one push and one pop.
+ *          > mitems_per_s              millions of items through the
+ *                                      queue per second.
+ *
+ */
+
+#include    <vector>
+#include    <algorithm>
+#include    <thread>
+#include    <mutex>
+#include    <atomic>
+#include    <chrono>
+#include    <cstdio>
+#include    <cstdlib>
+#include    <cstdint>
+
+#include    "../concurrent_queue.hpp"
+#include    "../linked_list.hpp"
+
+namespace
+{
+
+// producer index in the high bits, sequence number in the low bits
+constexpr int       sequence_bits = 40;
+
+struct locked_list
+{
+    static constexpr const char* name = "mutex_linked_list";
+    std::mutex              lock;
+    linked_list<uint64_t>   list;
+    void push(uint64_t item)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        list.push_back(item);
+    }
+    bool try_pop(uint64_t& item)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (list.empty()) return false;
+        item = *list.begin();
+        list.remove_index(0);
+        return true;
+    }
+};
+
+struct lock_free
+{
+    static constexpr const char* name = "concurrent_queue";
+    concurrent_queue<uint64_t> queue;
+    void push(uint64_t item)
+    {
+        queue.push(item);
+    }
+    bool try_pop(uint64_t& item)
+    {
+        return queue.try_pop(item);
+    }
+};
+
+struct result
+{
+    size_t  producers;
+    double  ns_per_item;
+    bool    pass;
+};
+
+template <class Queue>
+result run(size_t producers, size_t items)
+{
+    Queue                       q;
+    std::atomic<size_t>         popped{0};
+    std::atomic<bool>           go{false};
+    std::atomic<bool>           in_order{true};
+    std::vector<std::atomic<uint32_t>> seen(producers * items);
+    std::vector<std::thread>    workers;
+    const size_t                total = producers * items;
+    for (size_t p = 0; p < producers; p++)
+    {
+        workers.emplace_back([&, p] {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (uint64_t i = 0; i < items; i++) q.push((static_cast<uint64_t>(p) << sequence_bits) | i);
+        });
+        workers.emplace_back([&] {
+            std::vector<int64_t> last(producers, -1);
+            uint64_t item;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (popped.load(std::memory_order_relaxed) < total)
+            {
+                if (!q.try_pop(item))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                popped.fetch_add(1, std::memory_order_relaxed);
+                size_t  from = static_cast<size_t>(item >> sequence_bits);
+                int64_t seq  = static_cast<int64_t>(item & ((uint64_t(1) << sequence_bits) - 1));
+                if (seq <= last[from]) in_order.store(false, std::memory_order_relaxed);
+                last[from] = seq;
+                seen[from * items + seq].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    auto stop = std::chrono::steady_clock::now();
+    bool once = true;
+    for (const std::atomic<uint32_t>& s : seen) once = once && s.load() == 1;
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {producers, ns / static_cast<double>(total), once && in_order.load()};
+}
+
+template <class Queue>
+bool print_contestant(size_t producers, size_t items, bool last)
+{
+    bool pass = true;
+    std::printf("    {\n      \"contestant\": \"%s\",\n      \"runs\": [\n", Queue::name);
+    for (size_t p = 1; ; p = std::min(p * 2, producers))
+    {
+        result r = run<Queue>(p, items);
+        pass = pass && r.pass;
+        bool final_run = p == producers;
+        std::printf("        {\"producers\": %zu, \"consumers\": %zu, \"ns_per_item\": %.1f, \"mitems_per_s\": %.2f, \"pass\": %s}%s\n",
+                    r.producers, r.producers, r.ns_per_item, 1e3 / r.ns_per_item, r.pass ? "true" : "false", final_run ? "" : ",");
+        if (final_run) break;
+    }
+    std::printf("      ]\n    }%s\n", last ? "" : ",");
+    return pass;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t producers    = 32;
+    size_t items        = 200000;
+    if (argc > 1) producers = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2) items     = std::strtoull(argv[2], nullptr, 10);
+    if (producers == 0) producers = 1;
+
+    std::printf("{\n  \"benchmark\": \"queue\",\n  \"hardware_threads\": %u,\n  \"items_per_producer\": %zu,\n  \"contestants\": [\n",
+                std::thread::hardware_concurrency(), items);
+    bool pass = true;
+    pass = print_contestant<locked_list>(producers, items, false) && pass;
+    pass = print_contestant<lock_free>(producers, items, true) && pass;
+    std::printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+/*
+ *
+ *      Random benchmark
+ *
+ *      Measures the cost of every rng.hpp method on every engine,
+ *      single-threaded and across N threads, then runs a quick
+ *      statistical smoke test so that speed work cannot silently
+ *      degrade output quality.
+ *
+ *      Results are printed to stdout as a single JSON document.
+ *      The exit code is 1 if any statistical check fails.
+ *
+ *
+ *      Building:
+ *
+ *          > g++ -std=c++17 -O2 -pthread -I.. rng_bench.cpp -o rng_bench
+ *
+ *      Running:
+ *
+ *          > ./rng_bench [threads] [iterations]
+ *
+ *          threads defaults to std::thread::hardware_concurrency(),
+ *          iterations (per method, per thread) defaults to 1000000.
+ *
+ *
+ *      Reported per method:
+ *
+ *          > ns_per_draw               wall-clock nanoseconds per call,
+ *                                      for threaded runs all threads' calls
+ *                                      are counted against the same wall clock.
+ *          > gb_per_s                  bytes of returned values per second.
+ *
+ *
+ *      Statistical checks (per engine):
+ *
+ *          > chi_square_byte           number(0, 256) bucketed into 256 bins.
+ *          > chi_square_real           number(0.0, 1.0) bucketed into 100 bins.
+ *          > bit_frequency             every bit of UUID() is set half the time.
+ *          > percentage                percentage(12.5) hit rate.
+ *          > percentage_mask           percentage_mask(12.5) hit rate.
+ *
+ *          Each check is converted to a z-score, |z| above 5 fails.
+ *
+ */
+
+#include    <vector>
+#include    <string>
+#include    <thread>
+#include    <chrono>
+#include    <cmath>
+#include    <cstdio>
+#include    <cstdlib>
+#include    <cstdint>
+
+#include    "../rng.hpp"
+
+namespace
+{
+
+volatile uint64_t   sink;
+
+template <class Engine>
+struct engine_info;
+
+template <>
+struct engine_info<std::mt19937>
+{
+    static constexpr const char* name = "mt19937";
+    static void seed(std::mt19937& gen, uint32_t thread) { gen.seed(5489u + thread); }
+};
+
+template <>
+struct engine_info<philox4x32>
+{
+    static constexpr const char* name = "philox4x32";
+    static void seed(philox4x32& gen, uint32_t thread) { gen.seed(5489u, thread); }
+};
+
+struct result
+{
+    std::string name;
+    size_t      bytes;
+    double      ns_single;
+    double      ns_threaded;
+};
+
+// runs body(random, iterations) on 'threads' generators at once, returns wall ns per call
+template <class Engine, class Body>
+double time_method(size_t threads, size_t iterations, Body body)
+{
+    std::vector<basic_random<Engine>>   generators(threads);
+    std::vector<std::thread>            workers;
+    for (size_t t = 0; t < threads; t++) engine_info<Engine>::seed(generators[t].gen, static_cast<uint32_t>(t));
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t] { sink = sink + body(generators[t], iterations); });
+    }
+    for (auto& w : workers) w.join();
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return ns / static_cast<double>(threads * iterations);
+}
+
+template <class Engine, class Body>
+void add_method(std::vector<result>& results, const char* name, size_t bytes, size_t threads, size_t iterations, Body body)
+{
+    result r;
+    r.name          = name;
+    r.bytes         = bytes;
+    r.ns_single     = time_method<Engine>(1, iterations, body);
+    r.ns_threaded   = time_method<Engine>(threads, iterations, body);
+    results.push_back(r);
+}
+
+template <class Engine>
+std::vector<result> run_methods(size_t threads, size_t iterations)
+{
+    using R = basic_random<Engine>;
+    std::vector<result> results;
+    const std::vector<int>      values  = {1, 2, 3, 4, 5, 6, 7, 8};
+    const std::vector<double>   weights = {1, 2, 3, 4, 4, 3, 2, 1};
+
+    add_method<Engine>(results, "engine", Engine::max() == 0xFFFFFFFFu ? 4 : 8, threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.gen();
+        return acc;
+    });
+    add_method<Engine>(results, "number<int>", sizeof(int), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.number(1, 100);
+        return acc;
+    });
+    add_method<Engine>(results, "number<double>", sizeof(double), threads, iterations, [](R& r, size_t n) {
+        double acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.number(0.0, 1.0);
+        return static_cast<uint64_t>(acc);
+    });
+    add_method<Engine>(results, "number(vector)", sizeof(int), threads, iterations, [&values](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.number(values);
+        return acc;
+    });
+    add_method<Engine>(results, "weighted_number(min, max, mean, std_dev)", sizeof(int), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(0, 100, 50.0, 10.0);
+        return acc;
+    });
+    add_method<Engine>(results, "weighted_number(min, max, mean)", sizeof(int), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(0, 100, 50.0);
+        return acc;
+    });
+    add_method<Engine>(results, "weighted_number(mean, std_dev)", sizeof(double), threads, iterations, [](R& r, size_t n) {
+        double acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(50.0, 10.0);
+        return static_cast<uint64_t>(acc);
+    });
+    add_method<Engine>(results, "weighted_number(mean)", sizeof(double), threads, iterations, [](R& r, size_t n) {
+        double acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(50.0);
+        return static_cast<uint64_t>(acc);
+    });
+    add_method<Engine>(results, "weighted_number(vector)", sizeof(size_t), threads, iterations, [&weights](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(weights);
+        return acc;
+    });
+    add_method<Engine>(results, "weighted_number(vector, vector)", sizeof(size_t), threads, iterations, [&values, &weights](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.weighted_number(values, weights);
+        return acc;
+    });
+    add_method<Engine>(results, "percentage<int>", sizeof(bool), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.percentage(37);
+        return acc;
+    });
+    add_method<Engine>(results, "percentage<double>", sizeof(bool), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.percentage(12.5);
+        return acc;
+    });
+    add_method<Engine>(results, "percentage_mask", sizeof(uint64_t), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.percentage_mask(37);
+        return acc;
+    });
+    add_method<Engine>(results, "UUID", sizeof(uint64_t), threads, iterations, [](R& r, size_t n) {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; i++) acc += r.UUID();
+        return acc;
+    });
+    return results;
+}
+
+// philox4x32::generate() has no basic_random equivalent, it is timed on its own
+std::vector<result> run_philox_blocks(size_t threads, size_t iterations)
+{
+    auto body = [](basic_random<philox4x32>& r, size_t n) {
+        philox4x32::block_type  blocks[64];
+        uint64_t                acc = 0;
+        for (size_t i = 0; i < n; i += 64)
+        {
+            r.gen.generate(i, 64, blocks);
+            acc += blocks[63][0];
+        }
+        return acc;
+    };
+    std::vector<result> results;
+    add_method<philox4x32>(results, "generate(block)", sizeof(philox4x32::block_type), threads, iterations, body);
+    return results;
+}
+
+struct check
+{
+    std::string name;
+    double      z;
+};
+
+double chi_square_z(const std::vector<uint64_t>& bins, uint64_t samples)
+{
+    double expected = static_cast<double>(samples) / bins.size();
+    double chi = 0;
+    for (uint64_t b : bins) chi += (b - expected) * (b - expected) / expected;
+    double dof = static_cast<double>(bins.size() - 1);
+    return (chi - dof) / std::sqrt(2 * dof);
+}
+
+double proportion_z(uint64_t hits, uint64_t samples, double p)
+{
+    double n = static_cast<double>(samples);
+    return (hits - n * p) / std::sqrt(n * p * (1 - p));
+}
+
+template <class Engine>
+std::vector<check> run_checks(size_t samples)
+{
+    basic_random<Engine> r;
+    engine_info<Engine>::seed(r.gen, 0);
+    std::vector<check> checks;
+
+    std::vector<uint64_t> bytes(256);
+    for (size_t i = 0; i < samples; i++) bytes[r.number(0, 256)]++;
+    checks.push_back({"chi_square_byte", chi_square_z(bytes, samples)});
+
+    std::vector<uint64_t> reals(100);
+    for (size_t i = 0; i < samples; i++) reals[static_cast<size_t>(r.number(0.0, 1.0) * 100)]++;
+    checks.push_back({"chi_square_real", chi_square_z(reals, samples)});
+
+    uint64_t bits[64] = {};
+    for (size_t i = 0; i < samples; i++)
+    {
+        uint64_t u = r.UUID();
+        for (int b = 0; b < 64; b++) bits[b] += (u >> b) & 1;
+    }
+    double worst = 0;
+    for (int b = 0; b < 64; b++)
+    {
+        double z = proportion_z(bits[b], samples, 0.5);
+        if (std::fabs(z) > std::fabs(worst)) worst = z;
+    }
+    checks.push_back({"bit_frequency", worst});
+
+    uint64_t hits = 0;
+    for (size_t i = 0; i < samples; i++) hits += r.percentage(12.5);
+    checks.push_back({"percentage", proportion_z(hits, samples, 0.125)});
+
+    hits = 0;
+    for (size_t i = 0; i < samples / 64; i++) hits += __builtin_popcountll(r.percentage_mask(12.5));
+    checks.push_back({"percentage_mask", proportion_z(hits, samples / 64 * 64, 0.125)});
+    return checks;
+}
+
+bool print_engine(const char* name, const std::vector<result>& results, const std::vector<check>& checks, size_t threads, bool last)
+{
+    bool pass = true;
+    std::printf("    {\n      \"engine\": \"%s\",\n      \"methods\": [\n", name);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const result& r = results[i];
+        std::printf("        {\"method\": \"%s\", \"bytes\": %zu, "
+                    "\"single\": {\"ns_per_draw\": %.3f, \"gb_per_s\": %.4f}, "
+                    "\"threads_%zu\": {\"ns_per_draw\": %.3f, \"gb_per_s\": %.4f}}%s\n",
+                    r.name.c_str(), r.bytes,
+                    r.ns_single, r.bytes / r.ns_single,
+                    threads, r.ns_threaded, r.bytes / r.ns_threaded,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("      ],\n      \"checks\": [\n");
+    for (size_t i = 0; i < checks.size(); i++)
+    {
+        bool ok = std::fabs(checks[i].z) < 5.0;
+        pass = pass && ok;
+        std::printf("        {\"check\": \"%s\", \"z\": %.3f, \"pass\": %s}%s\n",
+                    checks[i].name.c_str(), checks[i].z, ok ? "true" : "false",
+                    i + 1 < checks.size() ? "," : "");
+    }
+    std::printf("      ]\n    }%s\n", last ? "" : ",");
+    return pass;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t threads      = std::thread::hardware_concurrency();
+    size_t iterations   = 1000000;
+    if (threads == 0) threads = 1;
+    if (argc > 1) threads       = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2) iterations    = std::strtoull(argv[2], nullptr, 10);
+
+    auto mt         = run_methods<std::mt19937>(threads, iterations);
+    auto philox     = run_methods<philox4x32>(threads, iterations);
+    auto blocks     = run_philox_blocks(threads, iterations);
+    philox.insert(philox.end(), blocks.begin(), blocks.end());
+
+    std::printf("{\n  \"benchmark\": \"rng\",\n  \"threads\": %zu,\n  \"iterations\": %zu,\n  \"engines\": [\n", threads, iterations);
+    bool pass = true;
+    pass = print_engine("mt19937", mt, run_checks<std::mt19937>(iterations), threads, false) && pass;
+    pass = print_engine("philox4x32", philox, run_checks<philox4x32>(iterations), threads, true) && pass;
+    std::printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+/*
+ *
+ *      Search benchmark
+ *
+ *      Measures lookups in one large sorted array of 64-bit keys:
+ *      std::lower_bound (binary search) against search_index,
+ *      interpolation_search() and learned_index from search.hpp.
+ *
+ *      Three key distributions are measured:
+ *          > uniform                   keys drawn evenly from [0, 2^40),
+ *                                      like IDs or timestamps.
+ *          > lognormal                 exp() of normally distributed
+ *                                      values, most keys bunched at the
+ *                                      low end with a long tail.
+ *          > duplicates                one value 9999 times in 10000,
+ *                                      the rest uniform: searches must
+ *                                      not walk the run of equal keys.
+ *
+ *      Half the lookups are keys in the array, half random values in
+ *      the same range. Every contestant's answers are checked against
+ *      std::lower_bound, or std::upper_bound for the upper_bound
+ *      contestants, the exit code is 1 if any differ.
+ *
+ *      The batch contestants pass every lookup to search_index's
+ *      lower_bound(keys, count, out) in one call. They run on the 64-bit
+ *      keys and on the same keys shifted right to fit an int32_t.
+ *
+ *      Results are printed to stdout as a single JSON document.
+ *
+ *
+ *      Building:
+ *
+ *          > g++ -std=c++17 -O2 -I.. search_bench.cpp -o search_bench
+ *
+ *          add -mavx2 (or -march=native) for learned_index's AVX2 scan,
+ *          the default x86-64 build scans 64-bit keys one at a time.
+ *
+ *      Running:
+ *
+ *          > ./search_bench [n] [lookups] [epsilon]
+ *
+ *          n defaults to 100000000 (needs about 2.5 GB), lookups to
+ *          1000000, epsilon (learned_index's error bound) to 32.
+ *
+ *
+ *      Reported per distribution:
+ *
+ *          > segments, depth           learned_index's model size, and
+ *                                      whether it was modelled at all.
+ *
+ *      Reported per contestant:
+ *
+ *          > ns_per_lookup             wall-clock nanoseconds per lookup,
+ *                                      independent lookups may overlap.
+ *          > ns_per_dependent_lookup   the same with every key waiting on
+ *                                      the previous answer: the latency
+ *                                      of one lookup, cache misses in a
+ *                                      row cannot overlap. null for the
+ *                                      batches, which take every key at
+ *                                      once.
+ *          > llc_misses_per_lookup     last-level cache read misses per
+ *                                      lookup from the Linux perf counters,
+ *                                      null where they are not available
+ *                                      (other systems, most VMs).
+ *
+ */
+
+#include    <vector>
+#include    <random>
+#include    <chrono>
+#include    <cmath>
+#include    <cstdio>
+#include    <cstdlib>
+#include    <cstdint>
+#include    <cstring>
+#include    <limits>
+#ifdef      __linux__
+#include    <linux/perf_event.h>
+#include    <sys/syscall.h>
+#include    <unistd.h>
+#endif
+
+#include    "../search.hpp"
+
+namespace
+{
+
+using key = uint64_t;
+
+// last-level cache read misses of this thread, -1 where the counter cannot be opened
+class miss_counter
+{
+private:
+    int fd = -1;
+public:
+    miss_counter()
+    {
+#ifdef      __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PERF_TYPE_HW_CACHE;
+        attr.config         = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~miss_counter()
+    {
+#ifdef      __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    long long read_count() const
+    {
+        long long count = -1;
+#ifdef      __linux__
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+        return count;
+    }
+};
+
+struct result
+{
+    double  ns_per_lookup;
+    double  ns_per_dependent;
+    double  misses_per_lookup;
+    bool    pass;
+};
+
+template <class Lookup>
+result run(const std::vector<key>& lookups, const std::vector<size_t>& expected, Lookup lookup)
+{
+    miss_counter misses;
+    size_t wrong = 0;
+    long long before = misses.read_count();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups.size(); i++) wrong += lookup(lookups[i]) != expected[i];
+    auto stop = std::chrono::steady_clock::now();
+    long long after = misses.read_count();
+    // the same lookups again, each key waiting on the previous answer: no position reaches 2^62,
+    // so the key is unchanged, but the processor cannot start a lookup before the last one is done
+    size_t last = 0;
+    auto chain_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups.size(); i++)
+    {
+        last = lookup(lookups[i] + (last >> 62));
+        wrong += last != expected[i];
+    }
+    auto chain_stop = std::chrono::steady_clock::now();
+    double count = static_cast<double>(lookups.size());
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    double chain = std::chrono::duration<double, std::nano>(chain_stop - chain_start).count();
+    return {ns / count, chain / count, before < 0 || after < 0 ? -1 : static_cast<double>(after - before) / count, wrong == 0};
+}
+
+// every key at once through a batch call, Batch(keys, count, out)
+template <typename T, class Batch>
+result run_batch(const std::vector<T>& lookups, const std::vector<size_t>& expected, Batch batch)
+{
+    miss_counter misses;
+    std::vector<size_t> out(lookups.size());
+    long long before = misses.read_count();
+    auto start = std::chrono::steady_clock::now();
+    batch(lookups.data(), lookups.size(), out.data());
+    auto stop = std::chrono::steady_clock::now();
+    long long after = misses.read_count();
+    double count = static_cast<double>(lookups.size());
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns / count, -1, before < 0 || after < 0 ? -1 : static_cast<double>(after - before) / count, out == expected};
+}
+
+struct contestant
+{
+    const char* name;
+    result      r;
+};
+
+bool print_result(const contestant& c, bool last)
+{
+    const result& r = c.r;
+    char misses[32] = "null";
+    char dependent[32] = "null";
+    if (r.misses_per_lookup >= 0) std::snprintf(misses, sizeof(misses), "%.2f", r.misses_per_lookup);
+    if (r.ns_per_dependent >= 0) std::snprintf(dependent, sizeof(dependent), "%.1f", r.ns_per_dependent);
+    std::printf("        {\"contestant\": \"%s\", \"ns_per_lookup\": %.1f, \"ns_per_dependent_lookup\": %s, \"llc_misses_per_lookup\": %s, \"pass\": %s}%s\n",
+                c.name, r.ns_per_lookup, dependent, misses, r.pass ? "true" : "false", last ? "" : ",");
+    return r.pass;
+}
+
+// the keys shifted right until the largest fits an int32_t: order is kept, neighbours may become equal
+result run_batch_int32(const std::vector<key>& sorted, const std::vector<key>& lookups)
+{
+    unsigned shift = 0;
+    while ((sorted.back() >> shift) > static_cast<key>(std::numeric_limits<int32_t>::max())) shift++;
+    auto narrow = [shift](key k) { return static_cast<int32_t>(std::min<key>(k >> shift, std::numeric_limits<int32_t>::max())); };
+    std::vector<int32_t> values(sorted.size());
+    std::vector<int32_t> keys(lookups.size());
+    std::vector<size_t> expected(lookups.size());
+    for (size_t i = 0; i < sorted.size(); i++) values[i] = narrow(sorted[i]);
+    for (size_t i = 0; i < lookups.size(); i++)
+    {
+        keys[i]     = narrow(lookups[i]);
+        expected[i] = std::lower_bound(values.begin(), values.end(), keys[i]) - values.begin();
+    }
+    search_index<int32_t> index(values.begin(), values.end(), true);
+    return run_batch(keys, expected, [&](const int32_t* k, size_t c, size_t* out) { index.lower_bound(k, c, out); });
+}
+
+template <class Draw>
+bool print_distribution(const char* name, size_t n, size_t count, size_t epsilon, Draw draw, bool last)
+{
+    std::mt19937_64 gen(42);
+    std::vector<key> sorted(n);
+    for (key& k : sorted) k = draw(gen);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<key> lookups(count);
+    for (size_t i = 0; i < count; i++) lookups[i] = i % 2 == 0 ? sorted[gen() % n] : draw(gen);
+    std::vector<size_t> expected(count);
+    std::vector<size_t> expected_upper(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        expected[i]         = std::lower_bound(sorted.begin(), sorted.end(), lookups[i]) - sorted.begin();
+        expected_upper[i]   = std::upper_bound(sorted.begin(), sorted.end(), lookups[i]) - sorted.begin();
+    }
+
+    std::vector<contestant> contestants;
+    contestants.push_back({"std::lower_bound", run(lookups, expected, [&](key k) -> size_t { return std::lower_bound(sorted.begin(), sorted.end(), k) - sorted.begin(); })});
+    contestants.push_back({"std::upper_bound", run(lookups, expected_upper, [&](key k) -> size_t { return std::upper_bound(sorted.begin(), sorted.end(), k) - sorted.begin(); })});
+    {
+        search_index<key> index(sorted.begin(), sorted.end(), true);
+        contestants.push_back({"search_index", run(lookups, expected, [&](key k) { return index.lower_bound(k); })});
+        contestants.push_back({"search_index upper_bound", run(lookups, expected_upper, [&](key k) { return index.upper_bound(k); })});
+        contestants.push_back({"search_index batch", run_batch(lookups, expected, [&](const key* k, size_t c, size_t* out) { index.lower_bound(k, c, out); })});
+    }
+    contestants.push_back({"search_index batch int32", run_batch_int32(sorted, lookups)});
+    contestants.push_back({"interpolation_search", run(lookups, expected, [&](key k) { return interpolation_search(sorted, k); })});
+    learned_index<key> learned(sorted.begin(), sorted.end(), true, epsilon);
+    contestants.push_back({"learned_index", run(lookups, expected, [&](key k) { return learned.lower_bound(k); })});
+    contestants.push_back({"learned_index upper_bound", run(lookups, expected_upper, [&](key k) { return learned.upper_bound(k); })});
+
+    std::printf("    {\n      \"distribution\": \"%s\",\n      \"modelled\": %s, \"segments\": %zu, \"depth\": %zu,\n      \"contestants\": [\n",
+                name, learned.modelled() ? "true" : "false", learned.segments(), learned.depth());
+    bool pass = true;
+    for (size_t i = 0; i < contestants.size(); i++) pass = print_result(contestants[i], i + 1 == contestants.size()) && pass;
+    std::printf("      ]\n    }%s\n", last ? "" : ",");
+    return pass;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t n        = 100000000;
+    size_t lookups  = 1000000;
+    size_t epsilon  = 32;
+    if (argc > 1) n         = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2) lookups   = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) epsilon   = std::strtoull(argv[3], nullptr, 10);
+    if (n == 0) n = 1;
+
+    std::printf("{\n  \"benchmark\": \"search\",\n  \"n\": %zu,\n  \"lookups\": %zu,\n  \"epsilon\": %zu,\n  \"distributions\": [\n", n, lookups, epsilon);
+    bool pass = true;
+    pass = print_distribution("uniform", n, lookups, epsilon, [](std::mt19937_64& g) { return g() >> 24; }, false) && pass;
+    pass = print_distribution("lognormal", n, lookups, epsilon, [](std::mt19937_64& g) {
+        std::lognormal_distribution<double> spread(0.0, 2.0);
+        return static_cast<key>(spread(g) * 1e6);
+    }, false) && pass;
+    pass = print_distribution("duplicates", n, lookups, epsilon, [](std::mt19937_64& g) -> key {
+        return g() % 10000 == 0 ? g() >> 24 : key(1) << 39;
+    }, true) && pass;
+    std::printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+    return pass ? 0 : 1;
+}
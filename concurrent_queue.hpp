@@ -0,0 +1,259 @@
+#ifndef     CONCURRENT_QUEUE
+#define     CONCURRENT_QUEUE 1
+
+#include    <atomic>
+#include    <algorithm>
+#include    <cstddef>
+#include    <new>
+#include    <utility>
+#include    <vector>
+
+// a lock-free multi-producer multi-consumer FIFO queue (Michael & Scott) for the cases
+// where a linked_list would otherwise sit behind one mutex shared by every thread
+// nodes are linked_list's: a next pointer and the element, here the pointer is atomic
+// a popped node is not freed straight away, another thread may still be reading it:
+// it is retired through hazard_pointers and freed once no thread has it published
+
+// hazard pointers: before reading a shared node a thread publishes its address in one of its slots,
+// retired nodes are freed only when no slot of any thread holds them
+// every thread that touches a concurrent_queue claims a record on first use and hands it back when it exits,
+// a record freed that way is reused, nodes it still had retired are freed by the next owner
+class hazard_pointers
+{
+public:
+    static constexpr size_t slots = 2;
+    struct alignas(64) record
+    {
+        std::atomic<void*>  hazard[slots] = {};
+        std::atomic<bool>   active{false};
+        record*             next = nullptr;
+        struct retired
+        {
+            void*   node;
+            void    (*destroy)(void*);
+        };
+        std::vector<retired> retired_nodes;
+    };
+    // the calling thread's record
+    static record*  local()
+    {
+        thread_local owner mine;
+        return mine.claimed;
+    }
+    // publishes the pointer held by source in slot, rereading until it is stable:
+    // once published and still in source, it cannot be freed until the slot is cleared
+    template <class N>
+    static N*       protect(record* r, size_t slot, const std::atomic<N*>& source)
+    {
+        N* p = source.load();
+        while (true)
+        {
+            r->hazard[slot].store(p);
+            N* again = source.load();
+            if (again == p) return p;
+            p = again;
+        }
+    }
+    static void     clear(record* r)
+    {
+        for (size_t i = 0; i < slots; i++) r->hazard[i].store(nullptr, std::memory_order_release);
+    }
+    // node must be unreachable from the shared structure, destroy frees it when it is safe to
+    static void     retire(record* r, void* node, void (*destroy)(void*))
+    {
+        r->retired_nodes.push_back({node, destroy});
+        // scanning costs one pass over every slot, waiting for a multiple of them keeps it amortised O(1)
+        if (r->retired_nodes.size() >= 2 * slots * count().load(std::memory_order_relaxed) + 64) scan(r);
+    }
+private:
+    struct owner
+    {
+        record* claimed;
+        owner() : claimed(acquire()) {}
+        ~owner()
+        {
+            clear(claimed);
+            scan(claimed);
+            claimed->active.store(false, std::memory_order_release);
+        }
+    };
+    static std::atomic<record*>&    records()
+    {
+        static std::atomic<record*> head{nullptr};
+        return head;
+    }
+    static std::atomic<size_t>&     count()
+    {
+        static std::atomic<size_t> n{0};
+        return n;
+    }
+    static record*  acquire()
+    {
+        for (record* r = records().load(std::memory_order_acquire); r != nullptr; r = r->next)
+        {
+            bool idle = false;
+            if (!r->active.load(std::memory_order_relaxed) && r->active.compare_exchange_strong(idle, true)) return r;
+        }
+        // records are never freed, so the list only grows and walking it needs no protection
+        record* r = new record;
+        r->active.store(true, std::memory_order_relaxed);
+        record* head = records().load(std::memory_order_relaxed);
+        do r->next = head;
+        while (!records().compare_exchange_weak(head, r, std::memory_order_acq_rel));
+        count().fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+    static void     scan(record* r)
+    {
+        std::vector<void*> published;
+        for (record* other = records().load(std::memory_order_acquire); other != nullptr; other = other->next)
+        {
+            for (size_t i = 0; i < slots; i++)
+            {
+                void* p = other->hazard[i].load();
+                if (p != nullptr) published.push_back(p);
+            }
+        }
+        std::sort(published.begin(), published.end());
+        size_t kept = 0;
+        for (record::retired& node : r->retired_nodes)
+        {
+            if (std::binary_search(published.begin(), published.end(), node.node)) r->retired_nodes[kept++] = node;
+            else node.destroy(node.node);
+        }
+        r->retired_nodes.resize(kept);
+    }
+};
+
+template <class T>
+class concurrent_queue
+{
+private:
+    struct Node
+    {
+        std::atomic<Node*>  next{nullptr};
+        // constructed by push(), moved out and destroyed by the pop() that makes this node the new dummy
+        alignas(T) unsigned char storage[sizeof(T)];
+        T*      data()
+        {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+    // head is a dummy node, the elements are the nodes after it
+    // head and tail get a cache line each, producers and consumers do not invalidate each other's
+    alignas(64) std::atomic<Node*> head;
+    alignas(64) std::atomic<Node*> tail;
+    static void destroy_node(void* node)
+    {
+        delete static_cast<Node*>(node);
+    }
+public:
+    concurrent_queue(const concurrent_queue&) = delete;
+    concurrent_queue& operator=(const concurrent_queue&) = delete;
+    template <class... Args>
+    void    emplace(Args&&... args)
+    {
+        Node* node = new Node;
+        try
+        {
+            new (node->storage) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            delete node;
+            throw;
+        }
+        hazard_pointers::record* r = hazard_pointers::local();
+        while (true)
+        {
+            Node* last = hazard_pointers::protect(r, 0, tail);
+            Node* next = last->next.load();
+            if (last != tail.load()) continue;
+            // tail lags behind, help the producer that linked next before trying again
+            if (next != nullptr)
+            {
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (last->next.compare_exchange_weak(next, node))
+            {
+                tail.compare_exchange_strong(last, node);
+                break;
+            }
+        }
+        hazard_pointers::clear(r);
+    }
+    void    push(const T& item)
+    {
+        emplace(item);
+    }
+    void    push(T&& item)
+    {
+        emplace(std::move(item));
+    }
+    // moves the oldest element into out, returns false if the queue was empty
+    bool    try_pop(T& out)
+    {
+        hazard_pointers::record* r = hazard_pointers::local();
+        while (true)
+        {
+            Node* first = hazard_pointers::protect(r, 0, head);
+            Node* last = tail.load();
+            Node* next = first->next.load();
+            // next stays valid while head is still first: it can only be retired after head moves past it
+            r->hazard[1].store(next);
+            if (first != head.load()) continue;
+            if (next == nullptr)
+            {
+                hazard_pointers::clear(r);
+                return false;
+            }
+            if (first == last)
+            {
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (head.compare_exchange_strong(first, next))
+            {
+                // next is the new dummy, only this thread may touch its element
+                T* item = next->data();
+                out = std::move(*item);
+                item->~T();
+                hazard_pointers::clear(r);
+                hazard_pointers::retire(r, first, destroy_node);
+                return true;
+            }
+        }
+    }
+    // a snapshot, other threads may push or pop right after it is taken
+    bool    empty()
+    {
+        hazard_pointers::record* r = hazard_pointers::local();
+        Node* first = hazard_pointers::protect(r, 0, head);
+        bool none = first->next.load() == nullptr;
+        hazard_pointers::clear(r);
+        return none;
+    }
+    concurrent_queue()
+    {
+        Node* dummy = new Node;
+        head.store(dummy);
+        tail.store(dummy);
+    }
+    // no other thread may use the queue any more
+    ~concurrent_queue()
+    {
+        Node* current = head.load();
+        Node* next = current->next.load();
+        delete current;
+        while (next != nullptr)
+        {
+            current = next;
+            next = current->next.load();
+            current->data()->~T();
+            delete current;
+        }
+    }
+};
+
+#endif
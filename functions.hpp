@@ -6,6 +6,8 @@
  *          > useful for searching through a large vector.
  *          > this code is an implementation of pseudo-code
  *          found here: https://en.wikipedia.org/wiki/Binary_search_algorithm#Procedure
+ *          > sorts the vector on every call, for repeated lookups build a
+ *          search_index (search.hpp) once and query it instead.
  * 
  * 
  *      lin_growth():
@@ -0,0 +1,471 @@
+#ifndef     INDEXED_LIST
+#define     INDEXED_LIST 1
+
+#include    <iostream>
+#include    <cstddef>
+#include    <cstdint>
+#include    <functional>
+#include    <iterator>
+#include    <new>
+#include    <type_traits>
+#include    <utility>
+#include    <vector>
+#include    "node_pool.hpp"
+
+// linked_list's interface, in insertion order, with removal by value in O(1):
+// a hash index maps every distinct value to the first and last of its nodes,
+// and the nodes holding equal values are chained to each other in list order
+// remove_value() and contains() are expected O(1), remove_value_all() is O(k) for k matches,
+// remove_index() and insert() walk from the nearer end of the doubly linked list
+//
+// memory per element: four pointers (prev, next, previous and next equal node), 32 bytes on 64-bit, plus T padded to 8
+// memory per distinct value: one 24 byte index slot, the index is kept between 3/8 and 3/4 full, 32 to 64 bytes
+
+template <class T, class Hash = std::hash<T>, template <class> class Pool = node_pool>
+class indexed_list
+{
+private:
+    struct Node
+    {
+        Node*   prev = nullptr;
+        Node*   next = nullptr;
+        Node*   prev_equal = nullptr;
+        Node*   next_equal = nullptr;
+        T       data;
+        template <class... Args>
+        Node(std::in_place_t, Args&&... args) : data(std::forward<Args>(args)...) {}
+    };
+    // one slot per distinct value, empty while first is nullptr
+    // the hash is kept so probing compares values only on a hash match, and growing never rehashes
+    struct Slot
+    {
+        Node*   first = nullptr;
+        Node*   last = nullptr;
+        size_t  hash = 0;
+    };
+    size_t l_size;
+    size_t distinct;
+    unsigned shift;
+    Node* start;
+    Node* tail;
+    // open addressing with linear probing, the size is a power of two
+    std::vector<Slot> slots;
+    Pool<Node> pool;
+    Hash hasher;
+    size_t  hash_of(const T& value) const
+    {
+        // std::hash of an integer is often the integer itself, multiplying spreads it over the high bits
+        return static_cast<size_t>(static_cast<uint64_t>(hasher(value)) * 0x9e3779b97f4a7c15ull);
+    }
+    size_t  home(size_t hash) const
+    {
+        return static_cast<size_t>(static_cast<uint64_t>(hash) >> shift);
+    }
+    // the slot holding value, or the empty slot where it would go
+    size_t  find_slot(const T& value, size_t hash) const
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t i = home(hash);; i = (i + 1) & mask)
+        {
+            const Slot& s = slots[i];
+            if (s.first == nullptr || (s.hash == hash && s.first->data == value)) return i;
+        }
+    }
+    Slot*   lookup(const T& value)
+    {
+        if (distinct == 0) return nullptr;
+        Slot& s = slots[find_slot(value, hash_of(value))];
+        return (s.first != nullptr) ? &s : nullptr;
+    }
+    // keeps room for one more distinct value
+    void    reserve_slot()
+    {
+        if ((distinct + 1) * 4 <= slots.size() * 3) return;
+        std::vector<Slot> old(slots.size() < 16 ? 16 : slots.size() * 2);
+        old.swap(slots);
+        shift = 64;
+        for (size_t n = slots.size(); n > 1; n >>= 1) shift--;
+        size_t mask = slots.size() - 1;
+        for (const Slot& s : old)
+        {
+            if (s.first == nullptr) continue;
+            size_t i = home(s.hash);
+            while (slots[i].first != nullptr) i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+    // empties slot i, later slots of the probe run move back so no tombstones are needed
+    void    erase_slot(size_t i)
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t j = (i + 1) & mask; slots[j].first != nullptr; j = (j + 1) & mask)
+        {
+            size_t k = home(slots[j].hash);
+            // slot j can fill the hole unless its home lies cyclically in (i, j]
+            bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (stays) continue;
+            slots[i] = slots[j];
+            i = j;
+        }
+        slots[i] = Slot();
+        distinct--;
+    }
+    template <class... Args>
+    Node*   create_node(Args&&... args)
+    {
+        Node* node = pool.allocate();
+        try
+        {
+            return new (node) Node(std::in_place, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            pool.deallocate(node);
+            throw;
+        }
+    }
+    void    destroy_node(Node* node)
+    {
+        node->~Node();
+        pool.deallocate(node);
+    }
+    // links node into the list before 'before' (nullptr appends)
+    // and into its value's chain after 'prev_equal', the last equal node ahead of it (nullptr if none)
+    void    link(Node* node, Node* before, Node* prev_equal, Slot& s)
+    {
+        node->next = before;
+        node->prev = (before != nullptr) ? before->prev : tail;
+        if (node->prev != nullptr) node->prev->next = node;
+        else start = node;
+        if (before != nullptr) before->prev = node;
+        else tail = node;
+        node->prev_equal = prev_equal;
+        node->next_equal = (prev_equal != nullptr) ? prev_equal->next_equal : s.first;
+        if (prev_equal != nullptr) prev_equal->next_equal = node;
+        else s.first = node;
+        if (node->next_equal != nullptr) node->next_equal->prev_equal = node;
+        else s.last = node;
+        l_size++;
+    }
+    // unlinks node from the list and from its chain, the slot is emptied with the last equal node
+    // s is only used when node is the first or last of its chain, otherwise it may be nullptr
+    void    unlink(Node* node, Slot* s)
+    {
+        if (node->prev != nullptr) node->prev->next = node->next;
+        else start = node->next;
+        if (node->next != nullptr) node->next->prev = node->prev;
+        else tail = node->prev;
+        if (node->prev_equal != nullptr) node->prev_equal->next_equal = node->next_equal;
+        else s->first = node->next_equal;
+        if (node->next_equal != nullptr) node->next_equal->prev_equal = node->prev_equal;
+        else s->last = node->prev_equal;
+        if (node->prev_equal == nullptr && node->next_equal == nullptr) erase_slot(static_cast<size_t>(s - slots.data()));
+        l_size--;
+    }
+    // the node at position index, walking from the nearer end
+    Node*   node_at(size_t index)
+    {
+        if (index < l_size / 2)
+        {
+            Node* current = start;
+            for (size_t i = 0; i < index; i++) current = current->next;
+            return current;
+        }
+        Node* current = tail;
+        for (size_t i = l_size - 1; i > index; i--) current = current->prev;
+        return current;
+    }
+    // builds the element, then links it before 'before', locating its place among equal values
+    // near_start says which side of 'before' is shorter to scan for the nearest equal node
+    template <class... Args>
+    Node*   emplace_before(Node* before, bool near_start, Args&&... args)
+    {
+        reserve_slot();
+        Node* node = create_node(std::forward<Args>(args)...);
+        size_t hash;
+        size_t i;
+        try
+        {
+            hash = hash_of(node->data);
+            i = find_slot(node->data, hash);
+        }
+        catch (...)
+        {
+            destroy_node(node);
+            throw;
+        }
+        Slot& s = slots[i];
+        if (s.first == nullptr)
+        {
+            s.hash = hash;
+            distinct++;
+            link(node, before, nullptr, s);
+            return node;
+        }
+        Node* prev_equal = nullptr;
+        if (before == nullptr) prev_equal = s.last;
+        else if (before != start && near_start)
+        {
+            for (Node* current = start; current != before; current = current->next)
+            {
+                if (current->data == node->data) prev_equal = current;
+            }
+        }
+        else if (before != start)
+        {
+            // the first equal node from 'before' on follows the new one, its predecessor in the chain precedes it
+            Node* next_equal = nullptr;
+            for (Node* current = before; current != nullptr; current = current->next)
+            {
+                if (current->data != node->data) continue;
+                next_equal = current;
+                break;
+            }
+            prev_equal = (next_equal != nullptr) ? next_equal->prev_equal : s.last;
+        }
+        link(node, before, prev_equal, s);
+        return node;
+    }
+    // forward iterator over the elements, Const selects const_iterator
+    template <bool Const>
+    class basic_iterator
+    {
+    private:
+        friend class indexed_list;
+        friend class basic_iterator<!Const>;
+        using node_pointer = typename std::conditional<Const, const Node*, Node*>::type;
+        node_pointer node = nullptr;
+        explicit basic_iterator(node_pointer n) : node(n) {}
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = typename std::conditional<Const, const T*, T*>::type;
+        using reference         = typename std::conditional<Const, const T&, T&>::type;
+        basic_iterator() {}
+        template <bool C = Const, class = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other) : node(other.node) {}
+        reference       operator*() const
+        {
+            return node->data;
+        }
+        pointer         operator->() const
+        {
+            return &node->data;
+        }
+        basic_iterator& operator++()
+        {
+            node = node->next;
+            return *this;
+        }
+        basic_iterator  operator++(int)
+        {
+            basic_iterator before = *this;
+            node = node->next;
+            return before;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.node == b.node;
+        }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.node != b.node;
+        }
+    };
+public:
+    using value_type        = T;
+    using size_type         = size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = const T&;
+    // elements are found by value, changing one in place would leave it under its old hash: iteration is read-only
+    using iterator          = basic_iterator<true>;
+    using const_iterator    = basic_iterator<true>;
+    const_iterator  begin() const
+    {
+        return const_iterator(start);
+    }
+    const_iterator  end() const
+    {
+        return const_iterator();
+    }
+    bool    empty() const
+    {
+        return (l_size == 0);
+    }
+    size_t  size() const
+    {
+        return l_size;
+    }
+    template <class... Args>
+    void    emplace_front(Args&&... args)
+    {
+        emplace_before(start, true, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    void    emplace_back(Args&&... args)
+    {
+        emplace_before(nullptr, false, std::forward<Args>(args)...);
+    }
+    void    add(const T& item)
+    {
+        emplace_front(item);
+    }
+    void    add(T&& item)
+    {
+        emplace_front(std::move(item));
+    }
+    void    push_back(const T& item)
+    {
+        emplace_back(item);
+    }
+    void    push_back(T&& item)
+    {
+        emplace_back(std::move(item));
+    }
+    void    insert(const T& item, size_t index)
+    {
+        if (index > l_size) return;
+        Node* before = (index == l_size) ? nullptr : node_at(index);
+        emplace_before(before, index < l_size / 2, item);
+    }
+    void    insert(T&& item, size_t index)
+    {
+        if (index > l_size) return;
+        Node* before = (index == l_size) ? nullptr : node_at(index);
+        emplace_before(before, index < l_size / 2, std::move(item));
+    }
+    bool    contains(const T& value)
+    {
+        return lookup(value) != nullptr;
+    }
+    // removes the first element equal to value
+    void    remove_value(const T& value)
+    {
+        Slot* s = lookup(value);
+        if (s == nullptr) return;
+        Node* node = s->first;
+        unlink(node, s);
+        destroy_node(node);
+    }
+    void    remove_value_all(const T& value)
+    {
+        Slot* s = lookup(value);
+        if (s == nullptr) return;
+        Node* node = s->first;
+        while (node != nullptr)
+        {
+            Node* next = node->next_equal;
+            if (node->prev != nullptr) node->prev->next = node->next;
+            else start = node->next;
+            if (node->next != nullptr) node->next->prev = node->prev;
+            else tail = node->prev;
+            destroy_node(node);
+            l_size--;
+            node = next;
+        }
+        erase_slot(static_cast<size_t>(s - slots.data()));
+    }
+    void    remove_index(size_t index)
+    {
+        if (empty())
+        {
+            std::cout << "empty()" << std::endl;
+            return;
+        }
+        if (index >= l_size)
+        {
+            std::cout << "Out of bounds!" << std::endl;
+            return;
+        }
+        Node* node = node_at(index);
+        // the chain ends lead to the slot, a node in the middle of its chain needs no lookup
+        if (node->prev_equal != nullptr && node->next_equal != nullptr) unlink(node, nullptr);
+        else unlink(node, &slots[find_slot(node->data, hash_of(node->data))]);
+        destroy_node(node);
+    }
+    void    print()
+    {
+        if (empty()) {
+            std::cout << "is_empty()" << std::endl;
+            return;
+        }
+        for (Node* current = start; current != nullptr; current = current->next)
+        {
+            std::cout << current->data;
+            if (current->next != nullptr) std::cout << ", ";
+        }
+        std::cout << "." << std::endl;
+    }
+    void    clear()
+    {
+        if (!std::is_trivially_destructible<T>::value || !Pool<Node>::bulk_release)
+        {
+            Node* current = start;
+            while (current != nullptr)
+            {
+                Node* next = current->next;
+                destroy_node(current);
+                current = next;
+            }
+        }
+        pool.release();
+        for (Slot& s : slots) s = Slot();
+        start = nullptr;
+        tail = nullptr;
+        l_size = 0;
+        distinct = 0;
+    }
+    indexed_list()
+    {
+        l_size = 0;
+        distinct = 0;
+        shift = 64;
+        start = nullptr;
+        tail = nullptr;
+    }
+    indexed_list(const indexed_list& other) : indexed_list()
+    {
+        for (const T& item : other) push_back(item);
+    }
+    indexed_list(indexed_list&& other) noexcept : indexed_list()
+    {
+        swap(other);
+    }
+    indexed_list& operator=(const indexed_list& other)
+    {
+        if (this != &other)
+        {
+            indexed_list copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    indexed_list& operator=(indexed_list&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+    void    swap(indexed_list& other) noexcept
+    {
+        std::swap(l_size, other.l_size);
+        std::swap(distinct, other.distinct);
+        std::swap(shift, other.shift);
+        std::swap(start, other.start);
+        std::swap(tail, other.tail);
+        slots.swap(other.slots);
+        pool.swap(other.pool);
+        std::swap(hasher, other.hasher);
+    }
+    ~indexed_list()
+    {
+        clear();
+    }
+};
+
+#endif
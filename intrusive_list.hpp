@@ -0,0 +1,335 @@
+#ifndef     INTRUSIVE_LIST
+#define     INTRUSIVE_LIST 1
+
+#include    <iostream>
+#include    <cstddef>
+#include    <iterator>
+#include    <type_traits>
+
+// linked_list's interface for objects that live somewhere else: the list never allocates, copies or destroys,
+// it links the objects themselves through a list_hook they inherit
+// an element knows its place, so remove(item) unlinks it in O(1) with no search
+//
+//  > struct task : list_hook<> { int id; };
+//  > intrusive_list<task> ready;
+//  > ready.push_back(t);
+//  > ready.remove(t);
+//
+// an object can be in one list per hook it inherits, tags tell the hooks apart:
+//
+//  > struct ready_tag; struct timer_tag;
+//  > struct task : list_hook<ready_tag>, list_hook<timer_tag> { ... };
+//  > intrusive_list<task, ready_tag> ready;
+//  > intrusive_list<task, timer_tag> timers;
+//
+// an element must be removed (or the list cleared) before the element is destroyed
+
+template <class T, class Tag>
+class intrusive_list;
+
+template <class Tag = void>
+class list_hook
+{
+private:
+    template <class, class> friend class intrusive_list;
+    list_hook* prev = nullptr;
+    list_hook* next = nullptr;
+public:
+    bool    linked() const
+    {
+        return (next != nullptr);
+    }
+    list_hook() {}
+    // a copy of an element is not in any list
+    list_hook(const list_hook&) {}
+    list_hook& operator=(const list_hook&)
+    {
+        return *this;
+    }
+};
+
+template <class T, class Tag = void>
+class intrusive_list
+{
+private:
+    using Hook = list_hook<Tag>;
+    size_t l_size;
+    // circular: head.next is the first element, head.prev the last, both point back at head when empty
+    Hook head;
+    static T*   item_of(Hook* hook)
+    {
+        return static_cast<T*>(hook);
+    }
+    static Hook* hook_of(T& item)
+    {
+        return static_cast<Hook*>(&item);
+    }
+    void    link_before(Hook* position, Hook* hook)
+    {
+        hook->next = position;
+        hook->prev = position->prev;
+        position->prev->next = hook;
+        position->prev = hook;
+        l_size++;
+    }
+    void    unlink(Hook* hook)
+    {
+        hook->prev->next = hook->next;
+        hook->next->prev = hook->prev;
+        hook->prev = nullptr;
+        hook->next = nullptr;
+        l_size--;
+    }
+    // the hook at position index, walking from the nearer end, &head for index == size()
+    Hook*   hook_at(size_t index)
+    {
+        Hook* current = &head;
+        if (index < l_size / 2)
+        {
+            for (size_t i = 0; i <= index; i++) current = current->next;
+            return current;
+        }
+        for (size_t i = l_size; i > index; i--) current = current->prev;
+        return current;
+    }
+    // bidirectional iterator over the elements, Const selects const_iterator
+    template <bool Const>
+    class basic_iterator
+    {
+    private:
+        friend class intrusive_list;
+        friend class basic_iterator<!Const>;
+        Hook* hook = nullptr;
+        explicit basic_iterator(Hook* h) : hook(h) {}
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = typename std::conditional<Const, const T*, T*>::type;
+        using reference         = typename std::conditional<Const, const T&, T&>::type;
+        basic_iterator() {}
+        template <bool C = Const, class = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other) : hook(other.hook) {}
+        reference       operator*() const
+        {
+            return *item_of(hook);
+        }
+        pointer         operator->() const
+        {
+            return item_of(hook);
+        }
+        basic_iterator& operator++()
+        {
+            hook = hook->next;
+            return *this;
+        }
+        basic_iterator  operator++(int)
+        {
+            basic_iterator before = *this;
+            hook = hook->next;
+            return before;
+        }
+        basic_iterator& operator--()
+        {
+            hook = hook->prev;
+            return *this;
+        }
+        basic_iterator  operator--(int)
+        {
+            basic_iterator before = *this;
+            hook = hook->prev;
+            return before;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.hook == b.hook;
+        }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.hook != b.hook;
+        }
+    };
+public:
+    static_assert(std::is_base_of<list_hook<Tag>, T>::value, "intrusive_list: T must inherit list_hook<Tag>");
+    using value_type        = T;
+    using size_type         = size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = const T&;
+    using iterator          = basic_iterator<false>;
+    using const_iterator    = basic_iterator<true>;
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list& operator=(const intrusive_list&) = delete;
+    iterator        begin()
+    {
+        return iterator(head.next);
+    }
+    iterator        end()
+    {
+        return iterator(&head);
+    }
+    const_iterator  begin() const
+    {
+        return const_iterator(head.next);
+    }
+    const_iterator  end() const
+    {
+        return const_iterator(const_cast<Hook*>(&head));
+    }
+    // the position of an element known to be in this list, found in O(1)
+    iterator        iterator_to(T& item)
+    {
+        return iterator(hook_of(item));
+    }
+    bool    empty() const
+    {
+        return (l_size == 0);
+    }
+    size_t  size() const
+    {
+        return l_size;
+    }
+    // an element already in a list is left where it is
+    void    add(T& item)
+    {
+        if (hook_of(item)->linked()) return;
+        link_before(head.next, hook_of(item));
+    }
+    void    push_back(T& item)
+    {
+        if (hook_of(item)->linked()) return;
+        link_before(&head, hook_of(item));
+    }
+    void    insert(T& item, size_t index)
+    {
+        if (index > l_size || hook_of(item)->linked()) return;
+        link_before(hook_at(index), hook_of(item));
+    }
+    // unlinks an element of this list in O(1)
+    void    remove(T& item)
+    {
+        if (!hook_of(item)->linked()) return;
+        unlink(hook_of(item));
+    }
+    void    remove_value(const T& value)
+    {
+        for (Hook* current = head.next; current != &head; current = current->next)
+        {
+            if (*item_of(current) != value) continue;
+            unlink(current);
+            return;
+        }
+    }
+    void    remove_value_all(const T& value)
+    {
+        Hook* current = head.next;
+        while (current != &head)
+        {
+            Hook* next = current->next;
+            if (*item_of(current) == value) unlink(current);
+            current = next;
+        }
+    }
+    void    remove_index(size_t index)
+    {
+        if (empty())
+        {
+            std::cout << "empty()" << std::endl;
+            return;
+        }
+        if (index >= l_size)
+        {
+            std::cout << "Out of bounds!" << std::endl;
+            return;
+        }
+        unlink(hook_at(index));
+    }
+    void    print()
+    {
+        if (empty()) {
+            std::cout << "is_empty()" << std::endl;
+            return;
+        }
+        for (Hook* current = head.next; current != &head; current = current->next)
+        {
+            std::cout << *item_of(current);
+            if (current->next != &head) std::cout << ", ";
+        }
+        std::cout << "." << std::endl;
+    }
+    // unlinks every element, the elements themselves are untouched
+    void    clear()
+    {
+        Hook* current = head.next;
+        while (current != &head)
+        {
+            Hook* next = current->next;
+            current->prev = nullptr;
+            current->next = nullptr;
+            current = next;
+        }
+        head.next = &head;
+        head.prev = &head;
+        l_size = 0;
+    }
+    intrusive_list()
+    {
+        l_size = 0;
+        head.next = &head;
+        head.prev = &head;
+    }
+    // the elements move over, only the first and last are touched to point at the new head
+    intrusive_list(intrusive_list&& other) noexcept : intrusive_list()
+    {
+        swap(other);
+    }
+    intrusive_list& operator=(intrusive_list&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+    void    swap(intrusive_list& other) noexcept
+    {
+        Hook* mine_first = head.next;
+        Hook* mine_last = head.prev;
+        Hook* other_first = other.head.next;
+        Hook* other_last = other.head.prev;
+        size_t mine_size = l_size;
+        l_size = other.l_size;
+        other.l_size = mine_size;
+        if (l_size == 0)
+        {
+            head.next = &head;
+            head.prev = &head;
+        }
+        else
+        {
+            head.next = other_first;
+            head.prev = other_last;
+            other_first->prev = &head;
+            other_last->next = &head;
+        }
+        if (other.l_size == 0)
+        {
+            other.head.next = &other.head;
+            other.head.prev = &other.head;
+        }
+        else
+        {
+            other.head.next = mine_first;
+            other.head.prev = mine_last;
+            mine_first->prev = &other.head;
+            mine_last->next = &other.head;
+        }
+    }
+    ~intrusive_list()
+    {
+        clear();
+    }
+};
+
+#endif
@@ -2,12 +2,21 @@
 #define     LINKED_LIST 1
 
 #include    <iostream>
+#include    <cstddef>
+#include    <functional>
+#include    <iterator>
+#include    <new>
+#include    <type_traits>
+#include    <utility>
+#include    "node_pool.hpp"
 
 // removing by value is time-inefficient
 // and becomes incredibly costly as list size becomes larger and larger
 // if possible and if list size is large use remove_index instead
 
-template <class T>
+// nodes come from Pool, see node_pool.hpp: by default they are carved out of large blocks and recycled
+// a tail pointer makes push_back() and appending splice() O(1), splice() and merge() relink nodes without copying them
+template <class T, template <class> class Pool = node_pool>
 class linked_list
 {
 private:
@@ -16,54 +25,236 @@ private:
     {
         Node*   next = nullptr;
         T       data;
-        Node() {}
-        Node(T d) : data(d) {}
+        // the element is built in place from whatever add(), insert() or emplace was given
+        template <class... Args>
+        Node(std::in_place_t, Args&&... args) : data(std::forward<Args>(args)...) {}
     };
     Node* start;
+    Node* tail;
+    Pool<Node> pool;
+    template <class... Args>
+    Node*   create_node(Args&&... args)
+    {
+        Node* node = pool.allocate();
+        try
+        {
+            return new (node) Node(std::in_place, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            pool.deallocate(node);
+            throw;
+        }
+    }
+    void    destroy_node(Node* node)
+    {
+        node->~Node();
+        pool.deallocate(node);
+    }
+    // links the chain first..last of count nodes in at position index
+    void    link_range(size_t index, Node* first, Node* last, size_t count)
+    {
+        if (index == 0)
+        {
+            last->next = start;
+            start = first;
+            if (tail == nullptr) tail = last;
+        }
+        else if (index == l_size)
+        {
+            tail->next = first;
+            tail = last;
+        }
+        else
+        {
+            Node* prev = start;
+            for (size_t i = 0; i < index - 1; i++) prev = prev->next;
+            last->next = prev->next;
+            prev->next = first;
+        }
+        l_size += count;
+    }
+    // merges two sorted chains by relinking, on ties the node from a comes first
+    template <class Compare>
+    static Node* merge_runs(Node* a, Node* b, Compare& less)
+    {
+        Node* head = nullptr;
+        Node** link = &head;
+        while (a != nullptr && b != nullptr)
+        {
+            if (less(b->data, a->data))
+            {
+                *link = b;
+                b = b->next;
+            }
+            else
+            {
+                *link = a;
+                a = a->next;
+            }
+            link = &(*link)->next;
+        }
+        *link = (a != nullptr) ? a : b;
+        return head;
+    }
+    // forward iterator over the elements, Const selects const_iterator
+    template <bool Const>
+    class basic_iterator
+    {
+    private:
+        friend class linked_list;
+        friend class basic_iterator<!Const>;
+        using node_pointer = typename std::conditional<Const, const Node*, Node*>::type;
+        node_pointer node = nullptr;
+        explicit basic_iterator(node_pointer n) : node(n) {}
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = typename std::conditional<Const, const T*, T*>::type;
+        using reference         = typename std::conditional<Const, const T&, T&>::type;
+        basic_iterator() {}
+        // iterator converts to const_iterator, not the other way round
+        template <bool C = Const, class = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other) : node(other.node) {}
+        reference       operator*() const
+        {
+            return node->data;
+        }
+        pointer         operator->() const
+        {
+            return &node->data;
+        }
+        basic_iterator& operator++()
+        {
+            node = node->next;
+            return *this;
+        }
+        basic_iterator  operator++(int)
+        {
+            basic_iterator before = *this;
+            node = node->next;
+            return before;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.node == b.node;
+        }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.node != b.node;
+        }
+    };
 public:
-    bool    empty()
+    using value_type        = T;
+    using size_type         = size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = const T&;
+    using iterator          = basic_iterator<false>;
+    using const_iterator    = basic_iterator<true>;
+    iterator        begin()
+    {
+        return iterator(start);
+    }
+    iterator        end()
+    {
+        return iterator();
+    }
+    const_iterator  begin() const
+    {
+        return const_iterator(start);
+    }
+    const_iterator  end() const
+    {
+        return const_iterator();
+    }
+    const_iterator  cbegin() const
+    {
+        return begin();
+    }
+    const_iterator  cend() const
+    {
+        return end();
+    }
+    bool    empty() const
     {
         return (l_size == 0);
     }
-    size_t  size()
+    size_t  size() const
     {
         return l_size;
     }
-    void    add(T item)
+    // constructs the element in place at the front, no temporary T is made
+    template <class... Args>
+    T&      emplace_front(Args&&... args)
     {
-        if (empty())
-        {
-            start = new Node(item);
-            l_size++;
-            return;
-        }
-        Node* new_node = new Node(item);
+        Node* new_node = create_node(std::forward<Args>(args)...);
         new_node->next = start;
         start = new_node;
+        if (tail == nullptr) tail = new_node;
         l_size++;
+        return new_node->data;
     }
-    void    insert(T item, size_t index)
+    // constructs the element in place at the end, O(1)
+    template <class... Args>
+    T&      emplace_back(Args&&... args)
     {
-        if (empty() && index != 0) return;
-        if (index == 0) add(item);
-        Node* current = start;
-        for (size_t i = 0; i < index - 1; i++)
+        Node* new_node = create_node(std::forward<Args>(args)...);
+        if (tail == nullptr) start = new_node;
+        else tail->next = new_node;
+        tail = new_node;
+        l_size++;
+        return new_node->data;
+    }
+    // constructs the element in place at position index, returns end() if index is past size()
+    template <class... Args>
+    iterator emplace_at(size_t index, Args&&... args)
+    {
+        if (index > l_size) return end();
+        if (index == 0)
         {
-            if (current == nullptr || current->next == nullptr) return;
-            current = current->next;
+            emplace_front(std::forward<Args>(args)...);
+            return begin();
         }
-        Node* to_add = new Node(item);
-        if (current->next == nullptr)
+        if (index == l_size)
         {
-            current->next = to_add;
-            l_size++;
-            return;
+            emplace_back(std::forward<Args>(args)...);
+            return iterator(tail);
         }
+        Node* current = start;
+        for (size_t i = 0; i < index - 1; i++) current = current->next;
+        Node* to_add = create_node(std::forward<Args>(args)...);
         to_add->next = current->next;
         current->next = to_add;
         l_size++;
+        return iterator(to_add);
+    }
+    void    add(const T& item)
+    {
+        emplace_front(item);
+    }
+    void    add(T&& item)
+    {
+        emplace_front(std::move(item));
+    }
+    void    push_back(const T& item)
+    {
+        emplace_back(item);
+    }
+    void    push_back(T&& item)
+    {
+        emplace_back(std::move(item));
+    }
+    void    insert(const T& item, size_t index)
+    {
+        emplace_at(index, item);
     }
-    void    remove_value(T value)
+    void    insert(T&& item, size_t index)
+    {
+        emplace_at(index, std::move(item));
+    }
+    void    remove_value(const T& value)
     {
         if (empty()) return;
         Node* current   =   start;
@@ -79,17 +270,19 @@ public:
             if (current == start)
             {
                 start = start->next;
-                delete current;
+                if (start == nullptr) tail = nullptr;
+                destroy_node(current);
                 l_size--;
                 return;
             }
             prev->next = current->next;
-            delete current;
+            if (current == tail) tail = prev;
+            destroy_node(current);
             l_size--;
             return;
         }
     }
-    void    remove_value_all(T value)
+    void    remove_value_all(const T& value)
     {
         if (empty()) return;
         Node* current   =   start;
@@ -105,13 +298,15 @@ public:
             if (current == start)
             {
                 start = start->next;
-                delete current;
+                if (start == nullptr) tail = nullptr;
+                destroy_node(current);
                 current = start;
                 l_size--;
                 continue;
             }
             prev->next = current->next;
-            delete current;
+            if (current == tail) tail = prev;
+            destroy_node(current);
             current = prev->next;
             l_size--;
         }
@@ -134,13 +329,14 @@ public:
         {
             if (start->next == nullptr)
             {
-                delete current;
+                destroy_node(current);
                 start = nullptr;
+                tail = nullptr;
                 l_size--;
                 return;
             }
             start = prev->next;
-            delete current;
+            destroy_node(current);
             l_size--;
             return;
         }
@@ -152,12 +348,13 @@ public:
         if (current->next != nullptr)
         {
             prev->next = current->next;
-            delete current;
+            destroy_node(current);
             l_size--;
             return;
         }
         prev->next = nullptr;
-        delete current;
+        tail = prev;
+        destroy_node(current);
         l_size--;
         return;
     }
@@ -176,17 +373,227 @@ public:
         }
         std::cout << "." << std::endl;
     }
+    // moves every element of other to the end of this list in O(1), other is left empty
+    void    splice(linked_list& other)
+    {
+        splice(l_size, other);
+    }
+    // moves every element of other to position index, only the nodes at the seam are relinked
+    void    splice(size_t index, linked_list& other)
+    {
+        if (&other == this || other.empty() || index > l_size) return;
+        pool.share(other.pool);
+        Node* first = other.start;
+        Node* last = other.tail;
+        size_t count = other.l_size;
+        other.start = nullptr;
+        other.tail = nullptr;
+        other.l_size = 0;
+        link_range(index, first, last, count);
+    }
+    // moves count elements of other, starting at position first, to position index
+    void    splice(size_t index, linked_list& other, size_t first, size_t count)
+    {
+        if (&other == this || count == 0 || index > l_size || first > other.l_size || count > other.l_size - first) return;
+        pool.share(other.pool);
+        Node* before = nullptr;
+        Node* begin_node = other.start;
+        for (size_t i = 0; i < first; i++)
+        {
+            before = begin_node;
+            begin_node = begin_node->next;
+        }
+        Node* last = begin_node;
+        for (size_t i = 1; i < count; i++) last = last->next;
+        if (before == nullptr) other.start = last->next;
+        else before->next = last->next;
+        if (last == other.tail) other.tail = before;
+        other.l_size -= count;
+        last->next = nullptr;
+        link_range(index, begin_node, last, count);
+    }
+    // merges the sorted list other into this sorted list by relinking nodes, other is left empty
+    // stable: of two equal elements the one from this list comes first
+    template <class Compare>
+    void    merge(linked_list& other, Compare less)
+    {
+        if (&other == this || other.empty()) return;
+        pool.share(other.pool);
+        // other's last node ends the merged list unless it sorts before ours
+        if (tail == nullptr || !less(other.tail->data, tail->data)) tail = other.tail;
+        start = merge_runs(start, other.start, less);
+        l_size += other.l_size;
+        other.start = nullptr;
+        other.tail = nullptr;
+        other.l_size = 0;
+    }
+    void    merge(linked_list& other)
+    {
+        merge(other, std::less<>());
+    }
+    // stable bottom-up merge sort, relinks nodes: no allocation, no element is copied or moved
+    template <class Compare>
+    void    sort(Compare less)
+    {
+        if (l_size < 2) return;
+        // bins[i] is empty or a sorted run of 2^i nodes, counting up like a binary number
+        Node* bins[64] = {};
+        Node* current = start;
+        while (current != nullptr)
+        {
+            Node* run = current;
+            current = current->next;
+            run->next = nullptr;
+            size_t i = 0;
+            for (; bins[i] != nullptr; i++)
+            {
+                run = merge_runs(bins[i], run, less);
+                bins[i] = nullptr;
+            }
+            bins[i] = run;
+        }
+        // higher bins hold earlier nodes, they go first to keep the sort stable
+        Node* run = nullptr;
+        for (Node* bin : bins)
+        {
+            if (bin != nullptr) run = (run == nullptr) ? bin : merge_runs(bin, run, less);
+        }
+        start = run;
+        tail = start;
+        while (tail->next != nullptr) tail = tail->next;
+    }
+    void    sort()
+    {
+        sort(std::less<>());
+    }
+    void    reverse()
+    {
+        Node* reversed = nullptr;
+        Node* current = start;
+        tail = start;
+        while (current != nullptr)
+        {
+            Node* next = current->next;
+            current->next = reversed;
+            reversed = current;
+            current = next;
+        }
+        start = reversed;
+    }
+    // removes every element pred returns true for in one pass, returns how many were removed
+    template <class Predicate>
+    size_t  remove_if(Predicate pred)
+    {
+        size_t removed = 0;
+        Node** link = &start;
+        Node* last = nullptr;
+        while (*link != nullptr)
+        {
+            Node* current = *link;
+            if (!pred(current->data))
+            {
+                last = current;
+                link = &current->next;
+                continue;
+            }
+            *link = current->next;
+            if (current == tail) tail = last;
+            destroy_node(current);
+            l_size--;
+            removed++;
+        }
+        return removed;
+    }
+    // removes every element equal to the one before it, returns how many were removed
+    template <class Equal>
+    size_t  unique(Equal equal)
+    {
+        size_t removed = 0;
+        if (start == nullptr) return removed;
+        Node* keep = start;
+        while (keep->next != nullptr)
+        {
+            Node* next = keep->next;
+            if (!equal(keep->data, next->data))
+            {
+                keep = next;
+                continue;
+            }
+            keep->next = next->next;
+            if (next == tail) tail = keep;
+            destroy_node(next);
+            l_size--;
+            removed++;
+        }
+        return removed;
+    }
+    size_t  unique()
+    {
+        return unique(std::equal_to<>());
+    }
     linked_list()
     {
         l_size = 0;
         start = nullptr;
+        tail = nullptr;
     }
-    ~linked_list()
+    // copies element by element into a pool of its own, the order is kept
+    linked_list(const linked_list& other) : linked_list()
+    {
+        for (const T& item : other) emplace_back(item);
+    }
+    // takes over the nodes and the pool they live in, nothing is copied
+    linked_list(linked_list&& other) noexcept : linked_list()
+    {
+        swap(other);
+    }
+    linked_list& operator=(const linked_list& other)
+    {
+        if (this != &other)
+        {
+            linked_list copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    linked_list& operator=(linked_list&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+    void    swap(linked_list& other) noexcept
     {
-        while (start != nullptr)
+        std::swap(l_size, other.l_size);
+        std::swap(start, other.start);
+        std::swap(tail, other.tail);
+        pool.swap(other.pool);
+    }
+    // destroys every element, then hands all node storage back to the pool at once
+    void    clear()
+    {
+        if (!std::is_trivially_destructible<T>::value || !Pool<Node>::bulk_release)
         {
-            remove_index(0);
+            Node* current = start;
+            while (current != nullptr)
+            {
+                Node* next = current->next;
+                current->~Node();
+                if (!Pool<Node>::bulk_release) pool.deallocate(current);
+                current = next;
+            }
         }
+        pool.release();
+        start = nullptr;
+        tail = nullptr;
+        l_size = 0;
+    }
+    ~linked_list()
+    {
+        clear();
     }
 };
 
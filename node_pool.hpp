@@ -0,0 +1,190 @@
+/*
+ *
+ *      Node pools for the list containers.
+ *
+ *      A pool hands out storage for one node type. linked_list takes the
+ *      pool as a template parameter, the allocator policy:
+ *
+ *          > linked_list<int>                  node_pool, the default
+ *          > linked_list<int, heap_nodes>      new and delete per node
+ *
+ *      node_pool carves nodes out of large contiguous blocks, recycles
+ *      removed nodes through a free list, and frees whole blocks at once
+ *      when the list is cleared. Nodes allocated one after another sit
+ *      next to each other in memory, so traversals stay cache friendly.
+ *      The blocks are reference counted: a list that received spliced
+ *      nodes keeps the blocks of the list they came from alive, so
+ *      clearing or destroying either list never frees the other's nodes.
+ *
+ *
+ *      A pool policy is a class template over the node type providing:
+ *
+ *          > T*    allocate()              uninitialised storage for one node
+ *          > void  deallocate(T*)          return one node's storage
+ *          > void  release()               return all storage at once,
+ *                                          every node must have been destroyed
+ *          > void  share(Pool& from)       nodes allocated by from move to this
+ *                                          pool's container (splice, merge), they
+ *                                          may be deallocated here from now on
+ *          > static constexpr bool bulk_release
+ *                                          true if release() frees nodes that
+ *                                          were never passed to deallocate()
+ *
+ */
+
+#ifndef     NODE_POOL
+#define     NODE_POOL 1
+
+#include    <cstddef>
+#include    <memory>
+#include    <vector>
+#include    <new>
+
+/**
+ *
+ * @brief   Slab allocator for nodes of type T.
+ *          Storage comes from blocks of 64 nodes, doubling up to 8192 nodes per block.
+ *          Released nodes are kept on a free list and handed out again before any new storage.
+ *          Not thread-safe, each container owns its pool.
+ *
+ */
+template <class T>
+class node_pool
+{
+private:
+    union slot
+    {
+        slot*   next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    struct arena
+    {
+        std::vector<std::unique_ptr<slot[]>> blocks;
+    };
+    static constexpr size_t first_block = 64;
+    static constexpr size_t last_block  = 8192;
+    std::shared_ptr<arena>                  own;
+    std::vector<std::shared_ptr<arena>>     kept;
+    slot*                                   free_list   = nullptr;
+    slot*                                   cursor      = nullptr;
+    slot*                                   limit       = nullptr;
+    size_t                                  block_nodes = first_block;
+    void grow()
+    {
+        if (!own) own = std::make_shared<arena>();
+        own->blocks.emplace_back(new slot[block_nodes]);
+        cursor  = own->blocks.back().get();
+        limit   = cursor + block_nodes;
+        if (block_nodes < last_block) block_nodes *= 2;
+    }
+    void keep(const std::shared_ptr<arena>& __a)
+    {
+        if (__a == own) return;
+        for (const std::shared_ptr<arena>& __k : kept) if (__k == __a) return;
+        kept.push_back(__a);
+    }
+public:
+    static constexpr bool bulk_release = true;
+    node_pool() {}
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+    node_pool(node_pool&& __other) noexcept
+    {
+        swap(__other);
+    }
+    node_pool& operator=(node_pool&& __other) noexcept
+    {
+        release();
+        swap(__other);
+        return *this;
+    }
+    T* allocate()
+    {
+        if (free_list != nullptr)
+        {
+            slot* __s = free_list;
+            free_list = __s->next;
+            return reinterpret_cast<T*>(__s);
+        }
+        if (cursor == limit) grow();
+        return reinterpret_cast<T*>(cursor++);
+    }
+    void deallocate(T* __p)
+    {
+        slot* __s   = reinterpret_cast<slot*>(__p);
+        __s->next   = free_list;
+        free_list   = __s;
+    }
+    /**
+     *
+     * @brief   Keeps the storage of __from alive for as long as this pool,
+     *          nodes allocated there may now be deallocated here.
+     *          Costs one entry per distinct source pool, repeated calls are free.
+     *
+     */
+    void share(node_pool& __from)
+    {
+        if (&__from == this) return;
+        if (__from.own) keep(__from.own);
+        for (const std::shared_ptr<arena>& __a : __from.kept) keep(__a);
+    }
+    /**
+     *
+     * @brief   Frees every block. Storage handed out before the call must no longer be used.
+     *          Blocks that nodes were spliced out of survive while the receiving pool holds them.
+     *
+     */
+    void release()
+    {
+        own.reset();
+        kept.clear();
+        free_list   = nullptr;
+        cursor      = nullptr;
+        limit       = nullptr;
+        block_nodes = first_block;
+    }
+    void swap(node_pool& __other) noexcept
+    {
+        own.swap(__other.own);
+        kept.swap(__other.kept);
+        std::swap(free_list, __other.free_list);
+        std::swap(cursor, __other.cursor);
+        std::swap(limit, __other.limit);
+        std::swap(block_nodes, __other.block_nodes);
+    }
+    /**
+     * @brief Bytes of node storage currently held, in use or free, not counting shared blocks.
+     */
+    size_t reserved() const
+    {
+        size_t __n = 0;
+        size_t __blocks = own ? own->blocks.size() : 0;
+        for (size_t __i = 0, __b = first_block; __i < __blocks; __i++, __b = __b < last_block ? __b * 2 : __b) __n += __b;
+        return __n * sizeof(slot);
+    }
+};
+
+/**
+ *
+ * @brief   Pool policy that allocates every node separately with new and frees it with delete.
+ *
+ */
+template <class T>
+class heap_nodes
+{
+public:
+    static constexpr bool bulk_release = false;
+    T* allocate()
+    {
+        return static_cast<T*>(::operator new(sizeof(T), std::align_val_t(alignof(T))));
+    }
+    void deallocate(T* __p)
+    {
+        ::operator delete(__p, std::align_val_t(alignof(T)));
+    }
+    void release() {}
+    void share(heap_nodes&) {}
+    void swap(heap_nodes&) noexcept {}
+};
+
+#endif
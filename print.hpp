@@ -23,21 +23,14 @@
  *          > char array[]
  *          > std::pair
  *          > std::tuple
- *          > std::array
- *          > std::vector
- *          > std::list
- *          > std::deque
- *          > std::set
- *          > std::multiset
- *          > std::unordered_set
- *          > std::unordered_multiset
- *          > std::map
- *          > std::multimap
- *          > std::unordered_map
- *          > std::unordered_multimap
  *          > std::bitset
  *          > std::variant
  *          > std::optional
+ *          > any container or array with begin() and end(), including
+ *            std::array, std::vector, std::list, std::deque, and all
+ *            ordered and unordered sets, multisets, maps and multimaps.
+ *            Containers are taken by const reference, never copied.
+ *            Sets print as {a, b}, maps as {k: v}, everything else as [a, b].
  * 
  *      Multidimensional containers tested and functional:
  *          
@@ -51,11 +44,14 @@
  *          > std::map
  * 
  * 
- *      Supported but only default container types have been tested:
+ *      Supports container adaptors:
  * 
- *              > std::stack
- *              > std::queue
- *              > std::priority_queue
+ *              > std::stack            (printed from the top down)
+ *              > std::queue            (printed from the front)
+ *              > std::priority_queue   (printed in heap order, top first)
+ * 
+ *          Adaptors are walked through their underlying container,
+ *          nothing is copied or popped.
  *           
  * 
  *      Supports smart pointers:
@@ -70,30 +66,95 @@
  *      Supports references (not fully tested.)
  * 
  * 
- *      Partial support for pointers:
+ *      Supports pointers:
  * 
- *          Pointer support limited to fundamental types.
- *          Container support to be implemented.
- *          
- *              Current container implementation:
- *
- *                  > std::array
- *                  > std::vector
- *                  > std::list
- *                  > std::deque
- *                  > std::set
- *                  > std::map
+ *          Pointers print the value they point to, whether it is
+ *          a fundamental type or a container.
+ * 
+ *      Formatting:
+ * 
+ *          Output is built in a fixed, per-thread buffer (see print_buffer).
+ *          A line that fits in the buffer is printed without any heap
+ *          allocation. Floating point numbers print as std::ostream
+ *          would, six significant digits, e.g. 0.333333.
+ *          Vectors, std::arrays and built-in arrays of numbers are
+ *          formatted in blocks, integers eight digits at a time with SSE2
+ *          and floating point numbers in their shortest form that reads
+ *          back as the same value, like Python, e.g. 0.3333333333333333.
+ *          Types with their own operator<< for std::ostream are still
+ *          supported, through a std::ostringstream.
+ * 
+ *      Structured output:
+ * 
+ *          > encoding(print_format::json)
+ *          > encoding(print_format::msgpack)
+ * 
+ *          Each call prints one array holding its arguments, e.g.
+ *          print(encoding(print_format::json), "id", v, m) prints
+ *          ["id",[1,2,3],{"k":"v"}]. Sequences, sets and adaptors
+ *          become arrays, std::pair and std::tuple arrays, maps objects
+ *          (JSON maps with keys other than strings or numbers become
+ *          arrays of [key, value]), std::optional a value or null,
+ *          std::variant its current value.
+ * 
+ *      Asynchronous mode:
+ * 
+ *          > Use 'async_print::instance().start();'
+ * 
+ *          print() keeps formatting on the calling thread, writing
+ *          is handed to a background thread. See async_print for
+ *          back-pressure, flush() and stop().
+ * 
+ *      Sinks:
+ * 
+ *          Output goes to a print_sink, std::cout by default.
+ *          Nothing is flushed per line, print() included.
+ * 
+ *          > fd_sink               (file descriptor, one writev() per call)
+ *          > buffered_file_sink    (appends through a buffer, see flush_policy)
+ *          > mmap_sink             (memory-mapped files rolling over at a fixed size)
+ *          > string_sink           (in memory)
+ * 
+ *          Choose one per call with to(), or for every call with
+ *          print_sink::set_default(). Pairing a sink with async_print
+ *          batches many lines into each write.
+ * 
+ *      Formatting into your own memory:
+ * 
+ *          > size_t n = print_to(buffer, capacity, "x =", x);
+ *          > print_to(str, "x =", x);
+ * 
+ *          Same output as print(), end() included. The length of the
+ *          full output is returned even when the buffer is too small.
+ *          No shared state, safe from any thread. Arithmetic, string and
+ *          container arguments are formatted without allocating, types
+ *          printed through their own operator<< still go through a
+ *          std::ostringstream.
  * 
  *      Parameter support:
  *          
  *          > sep() for separation between arguments
  *          > end() for newline or other end behaviour
  * 
- *          Both parameters are structs and should be called 
- *          with their constructs like this:
+ *          > max_items() to shorten large containers, a container
+ *            holding more than n elements prints its first and last
+ *            elements around "...", e.g. [1, 2, ..., 9, 10]
+ *          > streaming() to write long lines out in chunks of
+ *            print_buffer::capacity bytes while they are formatted,
+ *            instead of holding the whole line in memory
+ *          > to() to send the line to a sink other than the default
+ *          > encoding() to print JSON or MessagePack instead of text
+ * 
+ *          All parameters are structs, they can be passed anywhere
+ *          in the argument list, and should be called with their
+ *          constructs like this:
  * 
  *              > sep(" ")
  *              > end("\n")
+ *              > max_items(10)
+ *              > streaming()
+ *              > to(sink)
+ *              > encoding(print_format::json)
  *
  * 
  *      ***          <---KNOWN ISSUES--->          ***
@@ -104,9 +165,7 @@
  *      ***          <---TO DO--->          *** 
  * 
  *      Further testing for reference& support.
- *      Add additional pointer* &support for containers.
  *      Support for print(&memory_address).
- *      Testing for non-default stack, queue, and priority_queue containers.
  * 
  *      Improve documentation
  *      
@@ -119,415 +178,1415 @@
 
 #include    <iostream>
 #include    <string>
+#include    <string_view>
 #include    <sstream>
+#include    <charconv>
+#include    <cstring>
+#include    <cstdint>
+#include    <cmath>
+#include    <type_traits>
+#include    <iterator>
+#include    <utility>
+#include    <limits>
+#include    <algorithm>
+#include    <atomic>
+#include    <chrono>
+#include    <condition_variable>
+#include    <memory>
+#include    <mutex>
+#include    <thread>
+#include    <vector>
+#include    <cerrno>
+#include    <climits>
+#include    <unistd.h>
+#include    <sys/uio.h>
+#include    <sys/mman.h>
+#include    <fcntl.h>
+#ifdef      __SSE2__
+#include    <emmintrin.h>
+#endif
 
 struct sep
 {
-    std::string __arg = " ";
-    sep(std::string __sep) : __arg(__sep) {}
+    std::string_view __arg = " ";
+    sep(std::string_view __sep) : __arg(__sep) {}
 };
 
 struct end
 {
-    std::string __arg = " ";
-    end(std::string __end) : __arg(__end) {}
+    std::string_view __arg = " ";
+    end(std::string_view __end) : __arg(__end) {}
 };
 
-class PyPrint
+struct max_items
+{
+    size_t __arg;
+    max_items(size_t __max) : __arg(__max) {}
+};
+
+struct streaming
+{
+    bool __arg = true;
+    streaming(bool __on = true) : __arg(__on) {}
+};
+
+/**
+ * 
+ * @brief   Destination for print() output.
+ *          A sink receives each line as a short list of parts (the formatted line, then its end),
+ *          so it can write them with a single call.
+ *          Sinks can be chosen per call with the to() parameter, or for every call with set_default().
+ *          All sinks provided here are safe to share between threads.
+ * 
+ */
+class print_sink
 {
 private:
-    std::stringstream   stream;
-    std::string         output = "";
-    sep                 _sep;
-    end                 _end;
-    enum class separation {off, on};
-    // fundamental data types 
-    template <typename T>
-    void print(separation __separation, T& __arg)
+    static inline std::atomic<print_sink*> current{nullptr};
+public:
+    virtual ~print_sink() {}
+    /**
+     * 
+     * @brief   Writes __count parts, in order, as one unit.
+     * 
+     */
+    virtual void write(const std::string_view* __parts, size_t __count) = 0;
+    virtual void flush() {}
+    /**
+     * @brief Sink writing to std::cout, the default.
+     */
+    static print_sink& standard();
+    /**
+     * @brief Sink used by print() calls without a to() parameter.
+     */
+    static print_sink& get_default()
     {
-        stream << __arg;
-        if (__separation == separation::on) stream << _sep.__arg;
+        print_sink* __s = current.load(std::memory_order_acquire);
+        return __s != nullptr ? *__s : standard();
     }
-    // fundamental type pointers
-    template <typename T>
-    void print(separation __separation, T* __arg)
+    static void set_default(print_sink& __sink)
     {
-        stream << *__arg;
-        if (__separation == separation::on) stream << _sep.__arg;
+        current.store(&__sink, std::memory_order_release);
     }
-    // C style string handlers
-    void print(separation __separation, char __arg[])
+};
+
+/**
+ * 
+ * @brief   Writes to std::cout without flushing, output mixes correctly with the program's own use of std::cout.
+ * 
+ */
+class stdout_sink : public print_sink
+{
+public:
+    void write(const std::string_view* __parts, size_t __count) override
     {
-        stream << __arg;
-        if (__separation == separation::on) stream << _sep.__arg;
+        for (size_t __i = 0; __i < __count; __i++) std::cout.write(__parts[__i].data(), __parts[__i].size());
     }
-    void print(separation __separation, const char* __arg)
+    void flush() override
     {
-        stream << __arg;
-        if (__separation == separation::on) stream << _sep.__arg;
+        std::cout.flush();
     }
-    // std::pair<T, U>
-    #ifdef      _GLIBCXX_UTILITY
-        template <typename T, typename U>
-        void print(separation __separation, std::pair<T, U>& __arg)
-        {
-            stream << "(";
-            print(separation::off, __arg.first);
-            stream << ", ";
-            print(separation::off, __arg.second);
-            stream << ")";
-            if (__separation == separation::on) stream << _sep.__arg;
-        }
-    #endif
-    // std::tuple<T...>
-    #ifdef      _GLIBCXX_TUPLE
-    template <typename... T>
-    void print(separation __separation, std::tuple<T...>& __arg)
+};
+
+inline print_sink& print_sink::standard()
+{
+    static stdout_sink instance;
+    return instance;
+}
+
+/**
+ * 
+ * @brief   Writes straight to a file descriptor, all parts passed to write() go out in one writev() call.
+ *          A print() call is one writev(), under async_print a whole batch of lines is.
+ *          Nothing is buffered, so there is nothing to flush.
+ * 
+ * @param   __fd
+ *          File descriptor to write to.
+ * @param   __own
+ *          Optional (default: false).
+ *          Close the descriptor when the sink is destroyed.
+ * 
+ */
+class fd_sink : public print_sink
+{
+private:
+    int     fd;
+    bool    own;
+public:
+    fd_sink(int __fd, bool __own = false) : fd(__fd), own(__own) {}
+    ~fd_sink()
     {
-        stream << "(";
-        print_tuple(false, __arg);
-        stream << ")";
-        if (__separation == separation::on) stream << _sep.__arg;
+        if (own && fd >= 0) ::close(fd);
     }
-    template <size_t I = 0, typename... T>
-    void print_tuple(separation __separation, std::tuple<T...>& __arg)
+    fd_sink(const fd_sink&) = delete;
+    fd_sink& operator=(const fd_sink&) = delete;
+    /**
+     * 
+     * @brief   writev() until everything is written, retrying on EINTR and partial writes.
+     * 
+     */
+    static void writev_all(int __fd, iovec* __iov, int __count)
     {
-        if constexpr (I < sizeof...(T)) {
-        print(separation::off, std::get<I>(__arg));
-        if (I + 1 < sizeof...(T)) stream << ", ";
-        print_tuple<I + 1>(false, __arg);
+        while (__count > 0)
+        {
+            ssize_t __w = ::writev(__fd, __iov, __count);
+            if (__w < 0 && errno == EINTR) continue;
+            if (__w <= 0) return;
+            while (__count > 0 && static_cast<size_t>(__w) >= __iov->iov_len)
+            {
+                __w -= __iov->iov_len;
+                __iov++; __count--;
+            }
+            if (__count > 0)
+            {
+                __iov->iov_base = static_cast<char*>(__iov->iov_base) + __w;
+                __iov->iov_len -= __w;
+            }
         }
     }
-    #endif
-    // std::array<T, U>
-    #ifdef      _GLIBCXX_ARRAY
-    template <typename T, size_t U>
-    void print(separation __separation, std::array<T, U>& __arg)
+    static void write_parts(int __fd, const std::string_view* __parts, size_t __count)
     {
-        stream << "[";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        constexpr int __batch = IOV_MAX < 256 ? IOV_MAX : 256;
+        iovec __iov[__batch];
+        while (__count > 0)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            int __n = 0;
+            for (; __n < __batch && static_cast<size_t>(__n) < __count; __n++)
+            {
+                __iov[__n].iov_base = const_cast<char*>(__parts[__n].data());
+                __iov[__n].iov_len  = __parts[__n].size();
+            }
+            writev_all(__fd, __iov, __n);
+            __parts += __n; __count -= __n;
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
     }
-    template <typename T, size_t U>
-    void print(separation __separation, std::array<T, U>* __arg)
+    void write(const std::string_view* __parts, size_t __count) override
     {
-        stream << "[";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg->end()) stream << ", ";
-        }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        write_parts(fd, __parts, __count);
     }
-    #endif
-    // std::vector<T>
-    #ifdef      _GLIBCXX_VECTOR
-    template <typename T>
-    void print(separation __separation, std::vector<T>& __arg)
+    bool good() const
     {
-        stream << "[";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
-        }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        return fd >= 0;
     }
-    template <typename T>
-    void print(separation __separation, std::vector<T>* __arg)
+};
+
+/**
+ * 
+ * @brief   When a buffered_file_sink hands its buffer to the operating system.
+ *          when_full:  only when the buffer is full, fewest system calls.
+ *          every_line: after every print() call.
+ *          interval:   on the first print() call after the interval has elapsed since the last flush.
+ *          Every policy flushes on flush() and on destruction.
+ * 
+ */
+enum class flush_policy {when_full, every_line, interval};
+
+/**
+ * 
+ * @brief   Appends to a file through a buffer, many lines go out per system call.
+ * 
+ * @param   __path
+ *          File to append to, created if it does not exist.
+ * @param   __policy
+ *          Optional (default: flush_policy::when_full).
+ * @param   __capacity
+ *          Optional (default: 65536).
+ *          Buffer size in bytes.
+ * @param   __interval
+ *          Optional (default: 100ms).
+ *          Used by flush_policy::interval.
+ * 
+ */
+class buffered_file_sink : public print_sink
+{
+private:
+    int                                     fd;
+    flush_policy                            policy;
+    std::unique_ptr<char[]>                 data;
+    size_t                                  capacity;
+    size_t                                  length = 0;
+    std::chrono::steady_clock::duration     interval;
+    std::chrono::steady_clock::time_point   last_flush;
+    std::mutex                              lock;
+    void flush_locked()
     {
-        stream << "[";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg->end()) stream << ", ";
-        }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        if (length == 0) return;
+        std::string_view __all(data.get(), length);
+        fd_sink::write_parts(fd, &__all, 1);
+        length      = 0;
+        last_flush  = std::chrono::steady_clock::now();
     }
-    #endif
-    // std::list<T>
-    #ifdef      _STL_LIST_H
-    template <typename T>
-    void print(separation __separation, std::list<T>& __arg)
+public:
+    buffered_file_sink(const char* __path, flush_policy __policy = flush_policy::when_full, size_t __capacity = 1 << 16,
+                       std::chrono::milliseconds __interval = std::chrono::milliseconds(100))
+        : fd(::open(__path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)), policy(__policy),
+          data(new char[__capacity]), capacity(__capacity), interval(__interval), last_flush(std::chrono::steady_clock::now()) {}
+    ~buffered_file_sink()
     {
-        stream << "[";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
-        }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        flush();
+        if (fd >= 0) ::close(fd);
     }
-    template <typename T>
-    void print(separation __separation, std::list<T>* __arg)
+    buffered_file_sink(const buffered_file_sink&) = delete;
+    buffered_file_sink& operator=(const buffered_file_sink&) = delete;
+    void write(const std::string_view* __parts, size_t __count) override
     {
-        stream << "[";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
+        if (fd < 0) return;
+        std::lock_guard<std::mutex> __lock(lock);
+        size_t __n = 0;
+        for (size_t __i = 0; __i < __count; __i++) __n += __parts[__i].size();
+        if (length + __n > capacity)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg->end()) stream << ", ";
+            flush_locked();
+            if (__n > capacity)
+            {
+                // too large to buffer, written straight through
+                fd_sink::write_parts(fd, __parts, __count);
+                return;
+            }
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
-    }
-    #endif
-    // std::deque<T>
-    #ifdef      _GLIBCXX_DEQUE
-    template <typename T>
-    void print(separation __separation, std::deque<T>& __arg)
-    {
-        stream << "[";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        for (size_t __i = 0; __i < __count; __i++)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            std::memcpy(data.get() + length, __parts[__i].data(), __parts[__i].size());
+            length += __parts[__i].size();
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        if (policy == flush_policy::every_line) flush_locked();
+        else if (policy == flush_policy::interval && std::chrono::steady_clock::now() - last_flush >= interval) flush_locked();
     }
-    template <typename T>
-    void print(separation __separation, std::deque<T>* __arg)
+    void flush() override
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        if (fd >= 0) flush_locked();
+    }
+    bool good() const
+    {
+        return fd >= 0;
+    }
+};
+
+/**
+ * 
+ * @brief   Writes into memory-mapped files of a fixed size, no system call is made per line.
+ *          When a file is full the sink rolls over to the next one: __path, __path.1, __path.2, ...
+ *          Each finished file is truncated to the bytes actually written.
+ * 
+ * @param   __path
+ *          Name of the first file, existing files are overwritten.
+ * @param   __segment
+ *          Optional (default: 64 MiB).
+ *          Size of each file in bytes.
+ * 
+ */
+class mmap_sink : public print_sink
+{
+private:
+    std::string path;
+    size_t      segment;
+    size_t      index   = 0;
+    int         fd      = -1;
+    char*       map     = nullptr;
+    size_t      used    = 0;
+    std::mutex  lock;
+    void open_segment()
     {
-        stream << "[";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
+        std::string __name = index == 0 ? path : path + "." + std::to_string(index);
+        fd = ::open(__name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        used = 0;
+        if (fd < 0) return;
+        void* __m = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(segment)) == 0) __m = ::mmap(nullptr, segment, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (__m == MAP_FAILED)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg->end()) stream << ", ";
+            ::close(fd);
+            fd = -1;
+            return;
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        map = static_cast<char*>(__m);
     }
-    #endif
-    // std::set<T>
-    #ifdef      _GLIBCXX_SET
-    template <typename T>
-    void print(separation __separation, std::set<T>& __arg)
+    void close_segment()
+    {
+        if (fd < 0) return;
+        ::munmap(map, segment);
+        if (::ftruncate(fd, static_cast<off_t>(used)) != 0) {}
+        ::close(fd);
+        fd  = -1;
+        map = nullptr;
+    }
+public:
+    mmap_sink(const std::string& __path, size_t __segment = size_t(64) << 20) : path(__path), segment(__segment)
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        open_segment();
+    }
+    ~mmap_sink()
+    {
+        close_segment();
+    }
+    mmap_sink(const mmap_sink&) = delete;
+    mmap_sink& operator=(const mmap_sink&) = delete;
+    void write(const std::string_view* __parts, size_t __count) override
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        size_t __n = 0;
+        for (size_t __i = 0; __i < __count; __i++) __n += __parts[__i].size();
+        // a line is only split across files when it is larger than a whole file
+        if (used + __n > segment && used > 0)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            close_segment();
+            index++;
+            open_segment();
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        for (size_t __i = 0; __i < __count; __i++)
+        {
+            const char* __s = __parts[__i].data();
+            size_t      __k = __parts[__i].size();
+            while (__k > 0 && fd >= 0)
+            {
+                if (used == segment)
+                {
+                    close_segment();
+                    index++;
+                    open_segment();
+                    continue;
+                }
+                size_t __c = std::min(__k, segment - used);
+                std::memcpy(map + used, __s, __c);
+                used += __c; __s += __c; __k -= __c;
+            }
+        }
+    }
+    void flush() override
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        if (fd >= 0) ::msync(map, used, MS_ASYNC);
+    }
+    bool good() const
+    {
+        return fd >= 0;
+    }
+};
+
+/**
+ * 
+ * @brief   Collects output in memory.
+ * 
+ */
+class string_sink : public print_sink
+{
+private:
+    std::string         data;
+    mutable std::mutex  lock;
+public:
+    void write(const std::string_view* __parts, size_t __count) override
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        for (size_t __i = 0; __i < __count; __i++) data.append(__parts[__i]);
+    }
+    /**
+     * @brief Copy of everything written so far.
+     */
+    std::string str() const
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        return data;
+    }
+    void clear()
+    {
+        std::lock_guard<std::mutex> __lock(lock);
+        data.clear();
     }
+};
+
+/**
+ * 
+ * @brief   Output formats for print().
+ *          text:       the default, Python style, e.g. [1, 2, 3] and {k: v}, separated by sep() and ended with a full-stop.
+ *          json:       one JSON array per call holding every argument, followed by end().
+ *          msgpack:    one MessagePack array per call holding every argument, sep() and end() are not written.
+ *          max_items() only applies to text.
+ * 
+ */
+enum class print_format {text, json, msgpack};
+
+struct encoding
+{
+    print_format __arg;
+    encoding(print_format __format) : __arg(__format) {}
+};
+
+struct to
+{
+    print_sink* __arg;
+    to(print_sink& __sink) : __arg(&__sink) {}
+};
+
+/**
+ * 
+ * @brief   Formatting buffer used by PyPrint.
+ *          Each thread owns one, see local(), so a print() call that fits in 'capacity' bytes performs no heap allocation.
+ *          A print() made while another is formatting on the same thread, from a value's operator<<, uses a buffer of its own.
+ *          Arithmetic types are formatted without a locale: integers through format_decimal(),
+ *          floating point numbers with std::to_chars, six significant digits as std::ostream,
+ *          or in their shortest round-trip form in arrays written by write_numbers().
+ *          Longer lines spill into a std::string which is kept, and reused, for the rest of the thread's life.
+ *          print_to() instead points a buffer at the caller's memory.
+ * 
+ */
+class print_buffer
+{
+public:
+    static constexpr size_t capacity = 4096;
+private:
+    char        data[capacity];
+    // data, or the caller's memory for print_to(), which is never grown: bytes past 'limit' are only counted
+    char*       base    = data;
+    size_t      limit   = capacity;
+    size_t      length  = 0;
+    bool        spilled = false;
+    bool        external = false;
+    bool        scratch = false;
+    char        last    = 0;
+    std::string overflow;
+    print_sink* sink    = nullptr;
+    size_t      holdback = 0;
+    template <typename T, typename = void>
+    struct is_streamable : std::false_type {};
     template <typename T>
-    void print(separation __separation, std::set<T>* __arg)
+    struct is_streamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>> : std::true_type {};
+    // streaming: hand everything but the last 'holdback' bytes to the sink and reuse the buffer
+    void drain()
     {
-        stream << "{";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg->end()) stream << ", ";
-        }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        std::string_view __chunk(data, length - holdback);
+        sink->write(&__chunk, 1);
+        std::memmove(data, data + length - holdback, holdback);
+        length = holdback;
+    }
+    static int digits(uint64_t __v)
+    {
+        static constexpr uint64_t __pow10[20] = {
+            1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+            10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+            1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+        };
+        int __t = (64 - __builtin_clzll(__v | 1)) * 1233 >> 12;
+        return __t + (__v >= __pow10[__t]);
+    }
+    #ifdef      __SSE2__
+    // the eight decimal digits of __v < 100000000 as 16 bit lanes, most significant first
+    static __m128i eight_digits(uint32_t __v)
+    {
+        // abcdefgh -> abcd, efgh by multiplying with the inverse of 10000
+        const __m128i __abcdefgh    = _mm_cvtsi32_si128(static_cast<int>(__v));
+        const __m128i __abcd        = _mm_srli_epi64(_mm_mul_epu32(__abcdefgh, _mm_set1_epi32(static_cast<int>(0xd1b71759))), 45);
+        const __m128i __efgh        = _mm_sub_epi32(__abcdefgh, _mm_mul_epu32(__abcd, _mm_set1_epi32(10000)));
+        // each half x4, broadcast to four lanes, then divided by 1000, 100, 10 and 1 with multiply-high: a, ab, abc, abcd
+        const __m128i __v1  = _mm_slli_epi64(_mm_unpacklo_epi16(__abcd, __efgh), 2);
+        const __m128i __v2  = _mm_unpacklo_epi32(_mm_unpacklo_epi16(__v1, __v1), _mm_unpacklo_epi16(__v1, __v1));
+        const __m128i __v3  = _mm_mulhi_epu16(__v2, _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768));
+        const __m128i __v4  = _mm_mulhi_epu16(__v3, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768));
+        // a, ab, abc, abcd minus 10 x (0, a, ab, abc) leaves a, b, c, d
+        const __m128i __v5  = _mm_slli_epi64(_mm_mullo_epi16(__v4, _mm_set1_epi16(10)), 16);
+        return _mm_sub_epi16(__v4, __v5);
     }
     #endif
-    // std::multiset<T>
-    #ifdef      _STL_MULTISET_H
-    template <typename T>
-    void print(separation __separation, std::multiset<T> __arg)
+public:
+    /**
+     * 
+     * @brief   Writes the decimal digits of __v at __out, returns one past the last digit.
+     *          With SSE2, values of five digits or more are converted eight digits at a time.
+     * 
+     */
+    static char* format_decimal(char* __out, uint64_t __v)
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        #ifdef      __SSE2__
+        if (__v >= 10000)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            const __m128i   __zero = _mm_set1_epi8('0');
+            alignas(16) char __tmp[16];
+            int             __n = digits(__v);
+            if (__v < 100000000)
+            {
+                __m128i __d = _mm_add_epi8(_mm_packus_epi16(eight_digits(static_cast<uint32_t>(__v)), _mm_setzero_si128()), __zero);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(__tmp), __d);
+                std::memcpy(__out, __tmp + 8 - __n, __n);
+                return __out + __n;
+            }
+            uint64_t __high = __v / 100000000;
+            if (__high >= 100000000)
+            {
+                // twenty digits at most, the first four are left to to_chars
+                __out   = std::to_chars(__out, __out + 4, __high / 100000000).ptr;
+                __high %= 100000000;
+                __n     = 16;
+            }
+            __m128i __d = _mm_packus_epi16(eight_digits(static_cast<uint32_t>(__high)), eight_digits(static_cast<uint32_t>(__v % 100000000)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(__tmp), _mm_add_epi8(__d, __zero));
+            std::memcpy(__out, __tmp + 16 - __n, __n);
+            return __out + __n;
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        #endif
+        return std::to_chars(__out, __out + 20, __v).ptr;
     }
-    #endif
-    // std::unordered_set<T>
-    #ifdef      _GLIBCXX_UNORDERED_SET
-    template <typename T>
-    void print(separation __separation, std::unordered_set<T> __arg)
+    /**
+     * 
+     * @brief   Writes __arg at __out, returns one past the last character.
+     *          Integers in decimal, floating point numbers in general format with 6 significant digits,
+     *          identical to std::ostream's default, or with Shortest in the shortest form that reads back as the same value.
+     *          __out must have room for max_width<T>() characters.
+     * 
+     */
+    template <bool Shortest = false, typename T>
+    static char* format_number(char* __out, T __arg)
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        if constexpr (std::is_floating_point_v<T>)
         {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            if constexpr (Shortest) return std::to_chars(__out, __out + max_width<T>(), __arg).ptr;
+            else return std::to_chars(__out, __out + max_width<T>(), __arg, std::chars_format::general, 6).ptr;
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            unsigned long long __u = static_cast<unsigned long long>(__arg);
+            if (__arg < 0)
+            {
+                *__out++ = '-';
+                __u = 0 - __u;
+            }
+            return format_decimal(__out, __u);
+        }
+        else
+        {
+            return format_decimal(__out, __arg);
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
     }
-    #endif
-    // std::unordered_multiset<T>
-    #ifdef      _UNORDERED_SET_H
     template <typename T>
-    void print(separation __separation, std::unordered_multiset<T> __arg)
+    static constexpr size_t max_width()
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
-        {
-            print(separation::off, *it);
-            if (std::next(it) != __arg.end()) stream << ", ";
-        }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        // sign and digits, or sign, significant digits, point, exponent
+        if constexpr (std::is_integral_v<T>) return std::numeric_limits<T>::digits10 + 2;
+        else return std::numeric_limits<T>::max_digits10 + 10;
     }
-    #endif
-    // std::map<T, U>
-    #ifdef      _GLIBCXX_MAP
-    template <typename T, typename U>
-    void print(separation __separation, std::map<T, U>& __arg)
+    print_buffer() {}
+    /**
+     * 
+     * @brief   Formats into __buffer instead of the internal array, for print_to().
+     *          Writes past __capacity are dropped but still counted, see size().
+     * 
+     */
+    print_buffer(char* __buffer, size_t __capacity) : base(__buffer), limit(__capacity), external(true) {}
+    print_buffer(const print_buffer&) = delete;
+    print_buffer& operator=(const print_buffer&) = delete;
+    static print_buffer& local()
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
-        {
-            print(separation::off, it->first);
-            stream << ": ";
-            print(separation::off, it->second);
-            if (std::next(it) != __arg.end()) stream << ", ";
-        }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        thread_local print_buffer buffer;
+        return buffer;
     }
-    template <typename T, typename U>
-    void print(separation __separation, std::map<T, U>* __arg)
+    /**
+     * 
+     * @brief   Counts the print() calls running on this thread while it lives.
+     *          A value's operator<< may itself call print(): that call finds local() holding the outer line and must not reuse it.
+     * 
+     */
+    class claim
     {
-        stream << "{";
-        for (auto it = __arg->begin(); it != __arg->end(); it++)
+    private:
+        static size_t& depth()
         {
-            print(separation::off, it->first);
-            stream << ": ";
-            print(separation::off, it->second);
-            if (std::next(it) != __arg->end()) stream << ", ";
+            thread_local size_t __depth = 0;
+            return __depth;
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
-    }
-    #endif
-    // std::multimap<T, U>
-    #ifdef      _STL_MULTIMAP_H
-    template <typename T, typename U>
-    void print(separation __separation, std::multimap<T, U> __arg)
+    public:
+        claim() { depth()++; }
+        ~claim() { depth()--; }
+        claim(const claim&) = delete;
+        claim& operator=(const claim&) = delete;
+        bool nested() const { return depth() > 1; }
+    };
+    void write(const char* __s, size_t __n)
     {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        if (!spilled && length + __n <= limit)
         {
-            print(separation::off, it->first);
-            stream << ": ";
-            print(separation::off, it->second);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            std::memcpy(base + length, __s, __n);
+            length += __n;
+            return;
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
-    }
-    #endif
-    // std::unordered_map<T, U>
-    #ifdef      _GLIBCXX_UNORDERED_MAP
-    template <typename T, typename U>
-    void print(separation __separation, std::unordered_map<T, U> __arg)
-    {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        if (external)
         {
-            print(separation::off, it->first);
-            stream << ": ";
-            print(separation::off, it->second);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            if (length < limit) std::memcpy(base + length, __s, std::min(__n, limit - length));
+            length += __n;
+            if (__n > 0) last = __s[__n - 1];
+            return;
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
-    }
-    #endif
-    // std::unordered_multimap<T, U>
-    #ifdef      _UNORDERED_MAP_H
-    template <typename T, typename U>
-    void print(separation __separation, std::unordered_multimap<T, U> __arg)
-    {
-        stream << "{";
-        for (auto it = __arg.begin(); it != __arg.end(); it++)
+        if (sink != nullptr)
         {
-            print(separation::off, it->first);
-            stream << ": ";
-            print(separation::off, it->second);
-            if (std::next(it) != __arg.end()) stream << ", ";
+            while (length + __n > capacity)
+            {
+                if (length > holdback)
+                {
+                    drain();
+                    continue;
+                }
+                size_t __k = capacity - length;
+                std::memcpy(data + length, __s, __k);
+                length += __k; __s += __k; __n -= __k;
+            }
+            std::memcpy(data + length, __s, __n);
+            length += __n;
+            return;
         }
-        stream << "}";
-        if (__separation == separation::on) stream << _sep.__arg;
+        if (!spilled)
+        {
+            overflow.assign(data, length);
+            spilled = true;
+        }
+        overflow.append(__s, __n);
     }
-    #endif
-    // std::stack<T>
-    #ifdef      _GLIBCXX_STACK
-    template <typename T>
-    void print(separation __separation, std::stack<T> __arg)
+    /**
+     * 
+     * @brief   Room for __n bytes, at most capacity / 2, to be written in place.
+     *          End the write with commit().
+     * 
+     */
+    char* reserve(size_t __n)
     {
-        stream << "[";
-        while (!__arg.empty())
+        if (!spilled)
         {
-            print(separation::off, __arg.top());
-            __arg.pop();
-            if (__arg.size() > 0) stream << ", ";
+            if (length + __n <= limit) return base + length;
+            if (external)
+            {
+                // written to the internal array, then copied as far as the caller's memory goes
+                scratch = true;
+                return data;
+            }
+            if (sink != nullptr)
+            {
+                drain();
+                return data + length;
+            }
+            overflow.assign(data, length);
+            spilled = true;
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        size_t __at = overflow.size();
+        overflow.resize(__at + __n);
+        return overflow.data() + __at;
     }
-    #endif
-    // std::queue<T>, std::priority_queue<T>
-    #ifdef      _GLIBCXX_QUEUE
-    template <typename T>
-    void print(separation __separation, std::queue<T> __arg)
+    /**
+     * @brief Keeps the bytes written after reserve(), up to __end.
+     */
+    void commit(char* __end)
     {
-        stream << "[";
-        while (!__arg.empty())
+        if (scratch)
         {
-            print(separation::off, __arg.front());
-            __arg.pop();
-            if (__arg.size() > 0) stream << ", ";
+            scratch = false;
+            write(data, __end - data);
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
+        else if (spilled) overflow.resize(__end - overflow.data());
+        else length = __end - base;
     }
+    /**
+     * 
+     * @brief   Writes __count numbers separated by __sep, in blocks written in place.
+     *          Integers as by operator<<, floating point numbers in their shortest round-trip form.
+     * 
+     * @param   __null_nonfinite
+     *          Optional (default: false).
+     *          Writes infinities and NaN as null, for JSON.
+     * 
+     */
     template <typename T>
-    void print(separation __separation, std::priority_queue<T> __arg)
+    void write_numbers(const T* __p, size_t __count, std::string_view __sep, bool __null_nonfinite = false)
     {
-        stream << "[";
-        while (!__arg.empty())
+        const size_t __width = max_width<T>() + __sep.size();
+        if (__width > capacity / 2)
         {
-            print(separation::off, __arg.top());
-            __arg.pop();
-            if (__arg.size() > 0) stream << ", ";
+            char __tmp[max_width<T>()];
+            for (size_t __i = 0; __i < __count; __i++)
+            {
+                if (__i > 0) *this << __sep;
+                write(__tmp, format_number<true>(__tmp, __p[__i]) - __tmp);
+            }
+            return;
+        }
+        const size_t __block = capacity / 2 / __width;
+        for (size_t __i = 0; __i < __count;)
+        {
+            size_t  __k     = std::min(__block, __count - __i);
+            char*   __out   = reserve(__k * __width);
+            for (size_t __j = __i; __j < __i + __k; __j++)
+            {
+                if (__j > 0)
+                {
+                    std::memcpy(__out, __sep.data(), __sep.size());
+                    __out += __sep.size();
+                }
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    if (__null_nonfinite && !std::isfinite(__p[__j]))
+                    {
+                        std::memcpy(__out, "null", 4);
+                        __out += 4;
+                        continue;
+                    }
+                }
+                __out = format_number<true>(__out, __p[__j]);
+            }
+            commit(__out);
+            __i += __k;
         }
-        stream << "]";
-        if (__separation == separation::on) stream << _sep.__arg;
     }
-    #endif
-    // std::unique_ptr<T>, std::shared_ptr<T>, std::weak_ptr<T>
+    std::string_view view() const
+    {
+        return spilled ? std::string_view(overflow) : std::string_view(base, std::min(length, limit));
+    }
+    /**
+     * @brief Length of the line so far, including bytes counted but not stored by print_to().
+     */
+    size_t size() const
+    {
+        return spilled ? overflow.size() : length;
+    }
+    char back() const
+    {
+        if (spilled) return overflow.back();
+        return length <= limit ? base[length - 1] : last;
+    }
+    void truncate(size_t __n)
+    {
+        if (spilled) overflow.resize(__n); else length = __n;
+    }
+    void clear()
+    {
+        length  = 0;
+        spilled = false;
+        scratch = false;
+        sink    = nullptr;
+        overflow.clear();
+    }
+    /**
+     * 
+     * @brief   Switches the buffer to streaming: once full, its contents are passed to __sink in chunks
+     *          instead of spilling to the heap, so memory use stays at 'capacity' whatever the line length.
+     * 
+     * @param   __sink
+     *          Receives each chunk, nullptr turns streaming off.
+     * @param   __holdback
+     *          Number of trailing bytes always kept in the buffer, so the end of the line can still be edited.
+     * 
+     */
+    void stream_to(print_sink* __sink, size_t __holdback)
+    {
+        if (__holdback >= capacity / 2) return;
+        sink        = __sink;
+        holdback    = __holdback;
+    }
+    print_buffer& operator<<(std::string_view __arg)
+    {
+        write(__arg.data(), __arg.size());
+        return *this;
+    }
+    print_buffer& operator<<(const char* __arg)
+    {
+        return *this << std::string_view(__arg);
+    }
+    print_buffer& operator<<(const std::string& __arg)
+    {
+        return *this << std::string_view(__arg);
+    }
+    print_buffer& operator<<(char __arg)
+    {
+        write(&__arg, 1);
+        return *this;
+    }
+    print_buffer& operator<<(bool __arg)
+    {
+        return *this << (__arg ? std::string_view("true") : std::string_view("false"));
+    }
+    // every other arithmetic type, and a std::ostream fallback for anything else that can be streamed
+    template <typename T>
+    print_buffer& operator<<(const T& __arg)
+    {
+        if constexpr (std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+        {
+            return *this << static_cast<char>(__arg);
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            char __tmp[max_width<T>()];
+            write(__tmp, format_number(__tmp, __arg) - __tmp);
+            return *this;
+        }
+        else
+        {
+            static_assert(is_streamable<T>::value, "print(): type cannot be printed");
+            std::ostringstream __os;
+            __os << std::boolalpha << __arg;
+            return *this << std::string_view(__os.str());
+        }
+    }
+};
+
+/**
+ * 
+ * @brief   What async_print does with a line when its thread's ring is full.
+ * 
+ */
+enum class backpressure {drop, block};
+
+/**
+ * 
+ * @brief   Asynchronous backend for print().
+ *          Class is a singleton instance, create with: async_print& printer = async_print::instance();
+ *          While started, print() still formats on the calling thread but no longer writes:
+ *          the finished line is copied into a lock-free ring owned by that thread,
+ *          and a background thread collects every ring into batches, each passed to the target sink in one write() call.
+ *          The target is the default sink at start(), standard output is written with writev() directly.
+ *          While running, async_print is itself the default sink, so print(to(async_print::instance())) is never needed.
+ *          Lines from one thread keep their order and lines from different threads never interleave.
+ *          The rings are drained when stop() is called, and at program exit.
+ * 
+ * @warning Lines longer than the ring capacity are written synchronously.
+ *          Output written directly to std::cout while the backend runs may appear out of order.
+ * 
+ */
+class async_print : public print_sink
+{
+private:
+    // single producer (the owning thread), single consumer (the background thread)
+    // head and tail count bytes ever read and written, the ring only ever holds whole lines
+    struct ring
+    {
+        std::unique_ptr<char[]>     data;
+        size_t                      mask;
+        alignas(64) std::atomic<uint64_t>   head{0};
+        alignas(64) std::atomic<uint64_t>   tail{0};
+        std::atomic<bool>                   retired{false};
+        ring(size_t __capacity) : data(new char[__capacity]), mask(__capacity - 1) {}
+        size_t capacity() const { return mask + 1; }
+        void copy_in(uint64_t __pos, std::string_view __s)
+        {
+            size_t __at     = __pos & mask;
+            size_t __first  = std::min(__s.size(), capacity() - __at);
+            std::memcpy(data.get() + __at, __s.data(), __first);
+            std::memcpy(data.get(), __s.data() + __first, __s.size() - __first);
+        }
+    };
+    struct handle
+    {
+        std::shared_ptr<ring>   r;
+        uint64_t                session = 0;
+        ~handle() { if (r) r->retired.store(true, std::memory_order_release); }
+    };
+    std::mutex                          rings_lock;
+    std::vector<std::shared_ptr<ring>>  rings;
+    std::atomic<uint64_t>               rings_version{0};
+    std::mutex                          io_lock;
+    std::mutex                          wake_lock;
+    std::condition_variable             wake;
+    std::atomic<bool>                   sleeping{false};
+    std::atomic<bool>                   quit{false};
+    std::atomic<int>                    writers{0};
+    std::atomic<uint64_t>               dropped_lines{0};
+    std::thread                         consumer;
+    size_t                              ring_capacity   = 0;
+    backpressure                        policy          = backpressure::block;
+    uint64_t                            session         = 0;
+    std::atomic<bool>                   active{false};
+    print_sink*                         target          = nullptr;
+    print_sink*                         previous        = nullptr;
+    fd_sink                             standard_output{STDOUT_FILENO};
+    async_print() {}
+    ~async_print()
+    {
+        stop();
+    }
+    ring& local_ring()
+    {
+        thread_local handle __h;
+        if (__h.session != session)
+        {
+            if (__h.r) __h.r->retired.store(true, std::memory_order_release);
+            __h.r       = std::make_shared<ring>(ring_capacity);
+            __h.session = session;
+            std::lock_guard<std::mutex> __lock(rings_lock);
+            rings.push_back(__h.r);
+            rings_version.fetch_add(1, std::memory_order_release);
+        }
+        return *__h.r;
+    }
+    void notify()
+    {
+        if (sleeping.load(std::memory_order_acquire)) wake.notify_one();
+    }
+    // one pass over every ring, returns true if anything was written
+    bool drain(std::vector<std::shared_ptr<ring>>& __local, std::vector<std::string_view>& __parts, std::vector<uint64_t>& __tails)
+    {
+        __parts.clear(); __tails.clear();
+        for (auto& __r : __local)
+        {
+            uint64_t __head = __r->head.load(std::memory_order_relaxed);
+            uint64_t __tail = __r->tail.load(std::memory_order_acquire);
+            __tails.push_back(__tail);
+            if (__tail == __head) continue;
+            size_t __at     = __head & __r->mask;
+            size_t __n      = __tail - __head;
+            size_t __first  = std::min(__n, __r->capacity() - __at);
+            __parts.emplace_back(__r->data.get() + __at, __first);
+            if (__n > __first) __parts.emplace_back(__r->data.get(), __n - __first);
+        }
+        if (__parts.empty()) return false;
+        {
+            std::lock_guard<std::mutex> __lock(io_lock);
+            target->write(__parts.data(), __parts.size());
+        }
+        for (size_t __i = 0; __i < __local.size(); __i++) __local[__i]->head.store(__tails[__i], std::memory_order_release);
+        return true;
+    }
+    void run()
+    {
+        std::vector<std::shared_ptr<ring>>  __local;
+        std::vector<std::string_view>       __parts;
+        std::vector<uint64_t>               __tails;
+        uint64_t                            __version = ~uint64_t(0);
+        for (;;)
+        {
+            if (__version != rings_version.load(std::memory_order_acquire))
+            {
+                std::lock_guard<std::mutex> __lock(rings_lock);
+                // rings whose thread has exited are dropped once they are empty
+                rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<ring>& __r) {
+                    return __r->retired.load(std::memory_order_acquire) && __r->head.load() == __r->tail.load();
+                }), rings.end());
+                __local     = rings;
+                __version   = rings_version.load(std::memory_order_acquire);
+            }
+            if (drain(__local, __parts, __tails)) continue;
+            if (quit.load(std::memory_order_acquire))
+            {
+                // a ring registered after the last version check would be missed, the final drains use the full list
+                {
+                    std::lock_guard<std::mutex> __lock(rings_lock);
+                    __local = rings;
+                }
+                while (drain(__local, __parts, __tails)) {}
+                return;
+            }
+            sleeping.store(true, std::memory_order_release);
+            if (drain(__local, __parts, __tails))
+            {
+                sleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            std::unique_lock<std::mutex> __lock(wake_lock);
+            wake.wait_for(__lock, std::chrono::milliseconds(5));
+            sleeping.store(false, std::memory_order_relaxed);
+            // retired rings are pruned on the next pass
+            rings_version.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+public:
+    static async_print& instance()
+    {
+        static async_print instance;
+        return instance;
+    }
+    /**
+     * 
+     * @brief   Starts the background thread, print() calls made afterwards are asynchronous.
+     * 
+     * @param   __capacity
+     *          Optional (default: 65536).
+     *          Size in bytes of each thread's ring, rounded up to a power of two.
+     * @param   __policy
+     *          Optional (default: backpressure::block).
+     *          backpressure::block waits for room in a full ring, backpressure::drop discards the line and counts it, see dropped().
+     * @param   __target
+     *          Optional (default: the current default sink).
+     *          Sink the background thread writes to.
+     * 
+     */
+    void start(size_t __capacity = 1 << 16, backpressure __policy = backpressure::block, print_sink* __target = nullptr)
+    {
+        if (active.load()) return;
+        std::cout.flush();
+        previous    = &print_sink::get_default();
+        target      = __target != nullptr ? __target : previous;
+        if (target == &print_sink::standard() || target == this) target = &standard_output;
+        size_t __c = 64;
+        while (__c < __capacity) __c <<= 1;
+        ring_capacity   = __c;
+        policy          = __policy;
+        session++;
+        quit.store(false);
+        consumer = std::thread(&async_print::run, this);
+        active.store(true, std::memory_order_release);
+        print_sink::set_default(*this);
+    }
+    /**
+     * 
+     * @brief   Stops the background thread after every pending line has been written,
+     *          and restores the default sink in place at start().
+     * 
+     */
+    void stop()
+    {
+        if (!active.exchange(false)) return;
+        if (&print_sink::get_default() == this) print_sink::set_default(*previous);
+        // seq_cst on both sides: a writer that registered after this point sees active == false
+        while (writers.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+        quit.store(true, std::memory_order_release);
+        wake.notify_one();
+        consumer.join();
+        target->flush();
+        std::lock_guard<std::mutex> __lock(rings_lock);
+        rings.clear();
+    }
+    /**
+     * 
+     * @brief   Blocks until every line printed before the call has been written, then flushes the target.
+     * 
+     */
+    void flush() override
+    {
+        for (;;)
+        {
+            bool __empty = true;
+            {
+                std::lock_guard<std::mutex> __lock(rings_lock);
+                for (auto& __r : rings) __empty = __empty && __r->head.load(std::memory_order_acquire) == __r->tail.load(std::memory_order_acquire);
+            }
+            if (__empty || !active.load()) break;
+            wake.notify_one();
+            std::this_thread::yield();
+        }
+        std::lock_guard<std::mutex> __lock(io_lock);
+        if (target != nullptr) target->flush();
+    }
+    /**
+     * @brief Number of lines discarded by backpressure::drop.
+     */
+    uint64_t dropped() const
+    {
+        return dropped_lines.load(std::memory_order_relaxed);
+    }
+    /**
+     * 
+     * @brief   Queues __count parts, as one unit, on the calling thread's ring.
+     *          Once stopped, the parts are written synchronously to the last target.
+     * 
+     */
+    void write(const std::string_view* __parts, size_t __count) override
+    {
+        // store then load on different variables, mirrored in stop(): only seq_cst orders them
+        writers.fetch_add(1, std::memory_order_seq_cst);
+        if (!active.load(std::memory_order_seq_cst))
+        {
+            writers.fetch_sub(1, std::memory_order_release);
+            std::lock_guard<std::mutex> __lock(io_lock);
+            if (target != nullptr) target->write(__parts, __count); else print_sink::standard().write(__parts, __count);
+            return;
+        }
+        ring&       __r = local_ring();
+        size_t      __n = 0;
+        for (size_t __i = 0; __i < __count; __i++) __n += __parts[__i].size();
+        uint64_t    __tail = __r.tail.load(std::memory_order_relaxed);
+        if (__n > __r.capacity())
+        {
+            // can never fit, written in place once this thread's earlier lines are out
+            while (__r.head.load(std::memory_order_acquire) != __tail) { notify(); std::this_thread::yield(); }
+            std::lock_guard<std::mutex> __lock(io_lock);
+            target->write(__parts, __count);
+        }
+        else
+        {
+            while (__tail + __n - __r.head.load(std::memory_order_acquire) > __r.capacity())
+            {
+                if (policy == backpressure::drop)
+                {
+                    dropped_lines.fetch_add(1, std::memory_order_relaxed);
+                    writers.fetch_sub(1, std::memory_order_release);
+                    return;
+                }
+                notify();
+                std::this_thread::yield();
+            }
+            for (size_t __i = 0; __i < __count; __i++)
+            {
+                __r.copy_in(__tail, __parts[__i]);
+                __tail += __parts[__i].size();
+            }
+            // one store publishes every part, the background thread never sees half a unit
+            __r.tail.store(__tail, std::memory_order_release);
+            notify();
+        }
+        writers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+class PyPrint
+{
+private:
+    print_buffer&       stream = print_buffer::local();
+    sep                 _sep;
+    end                 _end;
+    size_t              _max_items = std::numeric_limits<size_t>::max();
+    bool                _streaming = false;
+    print_sink*         _sink = nullptr;
+    print_format        _format = print_format::text;
+    size_t              _items = 0;
+    enum class separation {off, on};
+    // parameters may be passed anywhere in the argument list
+    template <typename T>
+    struct is_option : std::bool_constant<std::is_same_v<T, sep> || std::is_same_v<T, end> || std::is_same_v<T, max_items> || std::is_same_v<T, streaming> || std::is_same_v<T, to> || std::is_same_v<T, encoding>> {};
+    void apply(const sep& __s)          { _sep = __s; }
+    void apply(const end& __e)          { _end = __e; }
+    void apply(const max_items& __m)    { _max_items = __m.__arg; }
+    void apply(const streaming& __s)    { _streaming = __s.__arg; }
+    void apply(const to& __t)           { _sink = __t.__arg; }
+    void apply(const encoding& __e)     { _format = __e.__arg; }
+    template <typename T>
+    void apply(const T&) {}
+    template <typename T>
+    void encode_argument(const T& __arg)
+    {
+        if constexpr (!is_option<T>::value) encode_item(_items++, __arg);
+    }
+    // container classification, any type with begin() and end() is a range
+    template <typename T, typename = void>
+    struct is_range : std::false_type {};
+    template <typename T>
+    struct is_range<T, std::void_t<decltype(std::begin(std::declval<const T&>())), decltype(std::end(std::declval<const T&>()))>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_streamable : std::false_type {};
+    template <typename T>
+    struct is_streamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_sized : std::false_type {};
+    template <typename T>
+    struct is_sized<T, std::void_t<decltype(std::size(std::declval<const T&>()))>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_keyed : std::false_type {};
+    template <typename T>
+    struct is_keyed<T, std::void_t<typename T::key_type>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_map : std::false_type {};
+    template <typename T>
+    struct is_map<T, std::void_t<typename T::key_type, typename T::mapped_type>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_adaptor : std::false_type {};
+    template <typename T>
+    struct is_adaptor<T, std::void_t<typename T::container_type>> : std::true_type {};
+    template <typename T, typename = void>
+    struct is_queue : std::false_type {};
+    template <typename T>
+    struct is_queue<T, std::void_t<decltype(std::declval<const T&>().front())>> : std::true_type {};
+    // std::vector, std::array and built-in arrays of numbers, formatted in blocks by print_buffer::write_numbers()
+    template <typename T, typename = void>
+    struct is_number_array : std::false_type {};
+    template <typename T>
+    struct is_number_array<T, std::void_t<decltype(std::data(std::declval<const T&>())), decltype(std::size(std::declval<const T&>()))>>
+    {
+        using V = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<const T&>()))>>;
+        static constexpr bool value = std::is_arithmetic_v<V> && !std::is_same_v<V, bool> && !std::is_same_v<V, char>
+                                   && !std::is_same_v<V, signed char> && !std::is_same_v<V, unsigned char>;
+    };
+    template <typename T, typename = void>
+    struct is_priority_queue : std::false_type {};
+    template <typename T>
+    struct is_priority_queue<T, std::void_t<typename T::value_compare>> : std::true_type {};
+    // std::stack, std::queue and std::priority_queue keep their container in the protected member 'c'
+    template <typename A>
+    static const typename A::container_type& underlying(const A& __arg)
+    {
+        struct access : A
+        {
+            static const typename A::container_type& get(const A& __a) { return __a.*(&access::c); }
+        };
+        return access::get(__arg);
+    }
+    template <typename T>
+    size_t count(const T& __arg)
+    {
+        if (_max_items == std::numeric_limits<size_t>::max()) return 0;
+        if constexpr (is_sized<T>::value) return std::size(__arg);
+        else return std::distance(std::begin(__arg), std::end(__arg));
+    }
+    template <bool Map, typename It>
+    void print_element(It __it)
+    {
+        if constexpr (Map)
+        {
+            print(separation::off, __it->first);
+            stream << ": ";
+            print(separation::off, __it->second);
+        }
+        else
+        {
+            print(separation::off, *__it);
+        }
+    }
+    // with max_items(n), containers holding more than n elements print their first and last elements around "..."
+    template <bool Map, typename It>
+    void print_elements(It __first, It __last, size_t __n)
+    {
+        if (__n <= _max_items)
+        {
+            for (auto it = __first; it != __last; it++)
+            {
+                if (it != __first) stream << ", ";
+                print_element<Map>(it);
+            }
+            return;
+        }
+        size_t  __head  = (_max_items + 1) / 2;
+        size_t  __tail  = _max_items / 2;
+        It      it      = __first;
+        for (size_t __i = 0; __i < __head; __i++, it++)
+        {
+            print_element<Map>(it);
+            stream << ", ";
+        }
+        stream << "...";
+        // bidirectional containers step back from the end, forward-only ones have to walk over the skipped elements
+        if constexpr (std::is_base_of_v<std::bidirectional_iterator_tag, typename std::iterator_traits<It>::iterator_category>) it = std::prev(__last, __tail);
+        else std::advance(it, __n - __head - __tail);
+        for (; it != __last; it++)
+        {
+            stream << ", ";
+            print_element<Map>(it);
+        }
+    }
+    // every container, taken by const reference and walked in place
+    template <typename T>
+    void print_range(const T& __arg)
+    {
+        if constexpr (is_adaptor<T>::value)
+        {
+            // a stack prints from the top down, a queue from the front, a priority_queue in heap order starting with its top
+            const auto& __c = underlying(__arg);
+            stream << "[";
+            if constexpr (is_queue<T>::value || is_priority_queue<T>::value) print_elements<false>(std::begin(__c), std::end(__c), count(__c));
+            else print_elements<false>(__c.rbegin(), __c.rend(), count(__c));
+            stream << "]";
+        }
+        else if constexpr (is_keyed<T>::value)
+        {
+            stream << "{";
+            print_elements<is_map<T>::value>(std::begin(__arg), std::end(__arg), count(__arg));
+            stream << "}";
+        }
+        else if constexpr (is_number_array<T>::value)
+        {
+            const auto* __p = std::data(__arg);
+            size_t      __n = std::size(__arg);
+            stream << "[";
+            if (__n <= _max_items) stream.write_numbers(__p, __n, ", ");
+            else
+            {
+                size_t __head = (_max_items + 1) / 2;
+                size_t __tail = _max_items / 2;
+                stream.write_numbers(__p, __head, ", ");
+                stream << (__head > 0 ? ", ..." : "...");
+                if (__tail > 0) stream << ", ";
+                stream.write_numbers(__p + __n - __tail, __tail, ", ");
+            }
+            stream << "]";
+        }
+        else
+        {
+            stream << "[";
+            print_elements<false>(std::begin(__arg), std::end(__arg), count(__arg));
+            stream << "]";
+        }
+    }
+    // arrays of anything but characters would otherwise stream as a pointer
+    template <typename T>
+    static constexpr bool is_container()
+    {
+        if constexpr (std::is_array_v<T>) return !std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>;
+        else return is_adaptor<T>::value || (is_range<T>::value && !is_streamable<T>::value);
+    }
+    // fundamental data types, strings, pointers, and every container
+    template <typename T>
+    void print(separation __separation, const T& __arg)
+    {
+        if constexpr (std::is_pointer_v<T>)
+        {
+            print(__separation, *__arg);
+            return;
+        }
+        else if constexpr (is_container<T>())
+        {
+            print_range(__arg);
+        }
+        else
+        {
+            stream << __arg;
+        }
+        if (__separation == separation::on) stream << _sep.__arg;
+    }
+    // C style string handlers
+    void print(separation __separation, char __arg[])
+    {
+        stream << __arg;
+        if (__separation == separation::on) stream << _sep.__arg;
+    }
+    void print(separation __separation, const char* __arg)
+    {
+        stream << __arg;
+        if (__separation == separation::on) stream << _sep.__arg;
+    }
+    // std::pair<T, U>
+    #ifdef      _GLIBCXX_UTILITY
+        template <typename T, typename U>
+        void print(separation __separation, const std::pair<T, U>& __arg)
+        {
+            stream << "(";
+            print(separation::off, __arg.first);
+            stream << ", ";
+            print(separation::off, __arg.second);
+            stream << ")";
+            if (__separation == separation::on) stream << _sep.__arg;
+        }
+    #endif
+    // std::tuple<T...>
+    #ifdef      _GLIBCXX_TUPLE
+    template <typename... T>
+    void print(separation __separation, const std::tuple<T...>& __arg)
+    {
+        stream << "(";
+        print_tuple(__arg);
+        stream << ")";
+        if (__separation == separation::on) stream << _sep.__arg;
+    }
+    template <size_t I = 0, typename... T>
+    void print_tuple(const std::tuple<T...>& __arg)
+    {
+        if constexpr (I < sizeof...(T)) {
+        print(separation::off, std::get<I>(__arg));
+        if (I + 1 < sizeof...(T)) stream << ", ";
+        print_tuple<I + 1>(__arg);
+        }
+    }
+    #endif
+    // std::unique_ptr<T>, std::shared_ptr<T>, std::weak_ptr<T>
     #ifdef      _GLIBCXX_MEMORY
     template <typename T>
-    void print(separation __separation, std::unique_ptr<T>& __arg)
+    void print(separation __separation, const std::unique_ptr<T>& __arg)
     {
-        print(true, *__arg.get());
+        print(__separation, *__arg.get());
     }
     template <typename T>
-    void print(separation __separation, std::shared_ptr<T>& __arg)
+    void print(separation __separation, const std::shared_ptr<T>& __arg)
     {
-        print(true, *__arg.get());
+        print(__separation, *__arg.get());
     }
     template <typename T>
-    void print(separation __separation, std::weak_ptr<T>& __arg)
+    void print(separation __separation, const std::weak_ptr<T>& __arg)
     {
-        print(true, *__arg.lock());
+        print(__separation, *__arg.lock());
     }
     #endif
     // std::bitset<T>
     #ifdef      _GLIBCXX_BITSET
     template <size_t T>
-    void print(separation __separation, std::bitset<T>& __arg)
+    void print(separation __separation, const std::bitset<T>& __arg)
     {
         stream << __arg.to_string();
         if (__separation == separation::on) stream << _sep.__arg;
@@ -536,7 +1595,7 @@ private:
     // std::variant<T...>
     #ifdef      _GLIBCXX_VARIANT
     template <typename... T>
-    void print(separation __separation, std::variant<T...>& __arg)
+    void print(separation __separation, const std::variant<T...>& __arg)
     {
         auto __vis = [this](const auto& __type) {
             print(separation::off, __type);
@@ -548,54 +1607,532 @@ private:
     // std::optional<T>
     #ifdef      _GLIBCXX_OPTIONAL
     template <typename T>
-    void print(separation __separation, std::optional<T>& __arg)
+    void print(separation __separation, const std::optional<T>& __arg)
     {
         if (__arg.has_value()) {print(separation::off, __arg.value());} else {stream << "No value!";}
         if (__separation == separation::on) stream << _sep.__arg;
     }    
     #endif
+    // structured output, print_format::json and print_format::msgpack
+    // the same classification as text mode, written straight into the buffer without building intermediate strings
+    template <typename T>
+    static size_t length(const T& __arg)
+    {
+        if constexpr (is_sized<T>::value) return std::size(__arg);
+        else return std::distance(std::begin(__arg), std::end(__arg));
+    }
+    // JSON object keys must be strings, maps keyed by anything else print as arrays of [key, value]
+    template <typename K>
+    static constexpr bool is_json_key()
+    {
+        return std::is_arithmetic_v<K> || std::is_convertible_v<const K&, std::string_view>;
+    }
+    void put_big_endian(uint64_t __v, int __bytes)
+    {
+        char __b[8];
+        for (int __i = __bytes - 1; __i >= 0; __i--, __v >>= 8) __b[__i] = static_cast<char>(__v & 0xff);
+        stream.write(__b, __bytes);
+    }
+    // MessagePack length prefix: fix format for small n, then 16 and 32 bit lengths
+    void put_header(uint8_t __fix, size_t __fix_max, uint8_t __8, uint8_t __16, size_t __n)
+    {
+        if (__n <= __fix_max) stream << static_cast<char>(__fix | __n);
+        else if (__8 != 0 && __n <= 0xff) { stream << static_cast<char>(__8); put_big_endian(__n, 1); }
+        else if (__n <= 0xffff) { stream << static_cast<char>(__16); put_big_endian(__n, 2); }
+        else { stream << static_cast<char>(__16 + 1); put_big_endian(__n, 4); }
+    }
+    void encode_null()
+    {
+        if (_format == print_format::json) stream << "null"; else stream << '\xc0';
+    }
+    void encode_string(std::string_view __s)
+    {
+        if (_format == print_format::msgpack)
+        {
+            put_header(0xa0, 31, 0xd9, 0xda, __s.size());
+            stream << __s;
+            return;
+        }
+        // runs of characters that need no escaping are copied in one write
+        static constexpr char __hex[] = "0123456789abcdef";
+        stream << '"';
+        size_t __run = 0;
+        for (size_t __i = 0; __i < __s.size(); __i++)
+        {
+            unsigned char __c = __s[__i];
+            if (__c >= 0x20 && __c != '"' && __c != '\\') continue;
+            stream.write(__s.data() + __run, __i - __run);
+            __run = __i + 1;
+            switch (__c)
+            {
+                case '"':   stream << "\\\""; break;
+                case '\\':  stream << "\\\\"; break;
+                case '\n':  stream << "\\n"; break;
+                case '\r':  stream << "\\r"; break;
+                case '\t':  stream << "\\t"; break;
+                default:
+                {
+                    char __u[6] = {'\\', 'u', '0', '0', __hex[__c >> 4], __hex[__c & 15]};
+                    stream.write(__u, 6);
+                }
+            }
+        }
+        stream.write(__s.data() + __run, __s.size() - __run);
+        stream << '"';
+    }
+    void begin_array(size_t __n)
+    {
+        if (_format == print_format::json) stream << '['; else put_header(0x90, 15, 0, 0xdc, __n);
+    }
+    void end_array()
+    {
+        if (_format == print_format::json) stream << ']';
+    }
+    template <typename T>
+    void encode_item(size_t __i, const T& __arg)
+    {
+        if (_format == print_format::json && __i > 0) stream << ',';
+        encode(__arg);
+    }
+    template <typename K, typename V>
+    void encode_pair(const K& __first, const V& __second)
+    {
+        begin_array(2);
+        encode_item(0, __first);
+        encode_item(1, __second);
+        end_array();
+    }
+    template <typename It>
+    void encode_sequence(It __first, It __last, size_t __n)
+    {
+        begin_array(__n);
+        size_t __i = 0;
+        for (auto it = __first; it != __last; it++) encode_item(__i++, *it);
+        end_array();
+    }
+    template <bool Object, typename It>
+    void encode_map(It __first, It __last, size_t __n)
+    {
+        if constexpr (!Object)
+        {
+            begin_array(__n);
+            size_t __i = 0;
+            for (auto it = __first; it != __last; it++)
+            {
+                if (_format == print_format::json && __i++ > 0) stream << ',';
+                encode_pair(it->first, it->second);
+            }
+            end_array();
+        }
+        else if (_format == print_format::msgpack)
+        {
+            put_header(0x80, 15, 0, 0xde, __n);
+            for (auto it = __first; it != __last; it++)
+            {
+                encode(it->first);
+                encode(it->second);
+            }
+        }
+        else
+        {
+            stream << '{';
+            for (auto it = __first; it != __last; it++)
+            {
+                if (it != __first) stream << ',';
+                // numeric keys are quoted, string keys already are
+                using K = std::decay_t<decltype(it->first)>;
+                if constexpr (std::is_convertible_v<const K&, std::string_view> || std::is_same_v<K, char>) encode(it->first);
+                else { stream << '"'; encode(it->first); stream << '"'; }
+                stream << ':';
+                encode(it->second);
+            }
+            stream << '}';
+        }
+    }
+    template <typename T>
+    void encode_range(const T& __arg)
+    {
+        if constexpr (is_adaptor<T>::value)
+        {
+            const auto& __c = underlying(__arg);
+            if constexpr (is_queue<T>::value || is_priority_queue<T>::value) encode_sequence(std::begin(__c), std::end(__c), length(__c));
+            else encode_sequence(__c.rbegin(), __c.rend(), length(__c));
+        }
+        else if constexpr (is_map<T>::value)
+        {
+            // MessagePack maps take any key, JSON objects only strings and numbers
+            if (_format == print_format::msgpack || is_json_key<typename T::key_type>()) encode_map<true>(std::begin(__arg), std::end(__arg), length(__arg));
+            else encode_map<false>(std::begin(__arg), std::end(__arg), length(__arg));
+        }
+        else if constexpr (is_number_array<T>::value)
+        {
+            if (_format == print_format::json)
+            {
+                stream << '[';
+                stream.write_numbers(std::data(__arg), std::size(__arg), ",", true);
+                stream << ']';
+            }
+            else encode_sequence(std::begin(__arg), std::end(__arg), length(__arg));
+        }
+        else
+        {
+            encode_sequence(std::begin(__arg), std::end(__arg), length(__arg));
+        }
+    }
+    // fundamental data types, strings, pointers, and every container
+    template <typename T>
+    void encode(const T& __arg)
+    {
+        using C = std::remove_cv_t<std::remove_pointer_t<T>>;
+        if constexpr (std::is_pointer_v<T> && std::is_same_v<C, char>)
+        {
+            if (__arg == nullptr) encode_null(); else encode_string(__arg);
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            if (__arg == nullptr) encode_null(); else encode(*__arg);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            if (_format == print_format::json) stream << __arg; else stream << (__arg ? '\xc3' : '\xc2');
+        }
+        else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+        {
+            char __c = static_cast<char>(__arg);
+            encode_string(std::string_view(&__c, 1));
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            if (_format == print_format::json) { stream << __arg; return; }
+            if constexpr (std::is_signed_v<T>)
+            {
+                if (__arg < 0)
+                {
+                    long long __v = __arg;
+                    if (__v >= -32) stream << static_cast<char>(__v);
+                    else if (__v >= INT8_MIN) { stream << '\xd0'; put_big_endian(static_cast<uint64_t>(__v), 1); }
+                    else if (__v >= INT16_MIN) { stream << '\xd1'; put_big_endian(static_cast<uint64_t>(__v), 2); }
+                    else if (__v >= INT32_MIN) { stream << '\xd2'; put_big_endian(static_cast<uint64_t>(__v), 4); }
+                    else { stream << '\xd3'; put_big_endian(static_cast<uint64_t>(__v), 8); }
+                    return;
+                }
+            }
+            unsigned long long __v = static_cast<unsigned long long>(__arg);
+            if (__v < 128) stream << static_cast<char>(__v);
+            else if (__v <= UINT8_MAX) { stream << '\xcc'; put_big_endian(__v, 1); }
+            else if (__v <= UINT16_MAX) { stream << '\xcd'; put_big_endian(__v, 2); }
+            else if (__v <= UINT32_MAX) { stream << '\xce'; put_big_endian(__v, 4); }
+            else { stream << '\xcf'; put_big_endian(__v, 8); }
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            if (_format == print_format::msgpack)
+            {
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    uint32_t __bits;
+                    std::memcpy(&__bits, &__arg, 4);
+                    stream << '\xca';
+                    put_big_endian(__bits, 4);
+                }
+                else
+                {
+                    double      __d = static_cast<double>(__arg);
+                    uint64_t    __bits;
+                    std::memcpy(&__bits, &__d, 8);
+                    stream << '\xcb';
+                    put_big_endian(__bits, 8);
+                }
+                return;
+            }
+            // JSON has no infinities or NaN, numbers are the shortest text that reads back to the same value
+            if (!std::isfinite(__arg)) { encode_null(); return; }
+            char __tmp[64];
+            auto __r = std::to_chars(__tmp, __tmp + sizeof(__tmp), __arg);
+            stream.write(__tmp, __r.ptr - __tmp);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            encode_string(__arg);
+        }
+        else if constexpr (is_container<T>())
+        {
+            encode_range(__arg);
+        }
+        else
+        {
+            // other types with an operator<< are written as strings
+            static_assert(is_streamable<T>::value, "print(): type cannot be printed");
+            std::ostringstream __os;
+            __os << std::boolalpha << __arg;
+            encode_string(__os.str());
+        }
+    }
+    #ifdef      _GLIBCXX_UTILITY
+    template <typename T, typename U>
+    void encode(const std::pair<T, U>& __arg)
+    {
+        encode_pair(__arg.first, __arg.second);
+    }
+    #endif
+    #ifdef      _GLIBCXX_TUPLE
+    template <typename... T>
+    void encode(const std::tuple<T...>& __arg)
+    {
+        begin_array(sizeof...(T));
+        std::apply([this](const auto&... __e) { size_t __i = 0; (encode_item(__i++, __e), ...); }, __arg);
+        end_array();
+    }
+    #endif
+    #ifdef      _GLIBCXX_MEMORY
+    template <typename T>
+    void encode(const std::unique_ptr<T>& __arg)
+    {
+        encode(__arg.get());
+    }
+    template <typename T>
+    void encode(const std::shared_ptr<T>& __arg)
+    {
+        encode(__arg.get());
+    }
+    template <typename T>
+    void encode(const std::weak_ptr<T>& __arg)
+    {
+        encode(__arg.lock().get());
+    }
+    #endif
+    #ifdef      _GLIBCXX_BITSET
+    template <size_t T>
+    void encode(const std::bitset<T>& __arg)
+    {
+        // same digits as text mode, most significant bit first
+        if (_format == print_format::json) stream << '"'; else put_header(0xa0, 31, 0xd9, 0xda, T);
+        for (size_t __i = T; __i-- > 0;) stream << (__arg[__i] ? '1' : '0');
+        if (_format == print_format::json) stream << '"';
+    }
+    #endif
+    #ifdef      _GLIBCXX_VARIANT
+    template <typename... T>
+    void encode(const std::variant<T...>& __arg)
+    {
+        if (__arg.valueless_by_exception()) { encode_null(); return; }
+        std::visit([this](const auto& __type) { encode(__type); }, __arg);
+    }
+    #endif
+    #ifdef      _GLIBCXX_OPTIONAL
+    template <typename T>
+    void encode(const std::optional<T>& __arg)
+    {
+        if (__arg.has_value()) encode(__arg.value()); else encode_null();
+    }
+    #endif
+    // text output plan, decided from the argument types at compile time
+    // a separator goes before every argument that follows another one, options take no place in the line
+    template <size_t I, typename... Arg>
+    static constexpr bool separated()
+    {
+        constexpr bool __value[] = {!is_option<Arg>::value...};
+        for (size_t __i = 0; __i < I; __i++) if (__value[__i]) return true;
+        return false;
+    }
+    // the last argument can never end in '.' or '!', so the full-stop is added without looking at the line
+    template <typename T>
+    static constexpr bool is_closed()
+    {
+        return (std::is_arithmetic_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>) || is_container<T>();
+    }
+    template <typename... Arg>
+    static constexpr bool closed()
+    {
+        bool __closed = true;
+        ((__closed = is_option<Arg>::value ? __closed : is_closed<Arg>()), ...);
+        return __closed;
+    }
+    // numbers, bool, characters and strings have a size bound known before formatting, and are written without capacity checks
+    template <typename T>
+    static constexpr bool is_bounded()
+    {
+        return is_option<T>::value || std::is_arithmetic_v<T> || std::is_convertible_v<const T&, std::string_view>;
+    }
+    template <typename T>
+    static size_t bound(const T& __arg)
+    {
+        if constexpr (is_option<T>::value) return 0;
+        else if constexpr (std::is_same_v<T, bool>) return 5;
+        else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) return 1;
+        else if constexpr (std::is_arithmetic_v<T>) return print_buffer::max_width<T>();
+        else return std::string_view(__arg).size();
+    }
+    template <bool Separated, typename T>
+    char* write_value(char* __out, const T& __arg)
+    {
+        if constexpr (is_option<T>::value) return __out;
+        else
+        {
+            if constexpr (Separated)
+            {
+                std::memcpy(__out, _sep.__arg.data(), _sep.__arg.size());
+                __out += _sep.__arg.size();
+            }
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                std::string_view __s = __arg ? "true" : "false";
+                std::memcpy(__out, __s.data(), __s.size());
+                return __out + __s.size();
+            }
+            else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+            {
+                *__out = static_cast<char>(__arg);
+                return __out + 1;
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                return print_buffer::format_number(__out, __arg);
+            }
+            else
+            {
+                std::string_view __s(__arg);
+                std::memcpy(__out, __s.data(), __s.size());
+                return __out + __s.size();
+            }
+        }
+    }
+    template <bool Separated, typename T>
+    void print_value(const T& __arg)
+    {
+        if constexpr (!is_option<T>::value)
+        {
+            if constexpr (Separated) stream << _sep.__arg;
+            print(separation::off, __arg);
+        }
+    }
+    template <size_t... I, typename... Arg>
+    void print_values(std::index_sequence<I...>, const Arg&... __args)
+    {
+        if constexpr ((is_bounded<Arg>() && ...))
+        {
+            // one reservation for the whole line, including separators and the full-stop
+            size_t __bound = ((bound(__args) + _sep.__arg.size()) + ... + 1);
+            if (__bound <= print_buffer::capacity / 2)
+            {
+                char* __out = stream.reserve(__bound);
+                ((__out = write_value<separated<I, Arg...>()>(__out, __args)), ...);
+                stream.commit(__out);
+                return;
+            }
+        }
+        (print_value<separated<I, Arg...>()>(__args), ...);
+    }
+    // the line, without its end, into 'stream'
+    template <typename... Arg>
+    void build(Arg&&... __args)
+    {
+        if (_format != print_format::text)
+        {
+            begin_array((size_t(!is_option<std::decay_t<Arg>>::value) + ... + 0));
+            (encode_argument(__args), ...);
+            end_array();
+            return;
+        }
+        print_values(std::index_sequence_for<Arg...>(), __args...);
+        if constexpr (closed<std::decay_t<Arg>...>()) stream << '.';
+        else if (stream.size() == 0 || (stream.back() != '!' && stream.back() != '.')) stream << '.';
+    }
 public:
     template <typename... Arg>
     void start_print(Arg&&... __args)
     {
-        stream << std::boolalpha;
-        (print(separation::on, __args), ...);
-        std::string output = stream.str();
-        size_t found = output.rfind(_sep.__arg);
-        output.erase(found, found + (_sep.__arg.size() - 1));
-        if (output.back() != '!' && output.back() != '.') output += ".";
-        std::cout << output << _end.__arg;
+        (apply(__args), ...);
+        if (_sink == nullptr) _sink = &print_sink::get_default();
+        stream.clear();
+        // text keeps its last character in the buffer for the full-stop check, structured output edits nothing
+        if (_streaming) stream.stream_to(_sink, _format == print_format::text ? 1 : 0);
+        build(__args...);
+        std::string_view parts[2] = {stream.view(), _format != print_format::msgpack ? _end.__arg : std::string_view()};
+        _sink->write(parts, 2);
+        stream.stream_to(nullptr, 0);
+    }
+    /**
+     * 
+     * @brief   Formats the line and its end into the buffer given to the constructor.
+     * 
+     * @return  Length of the whole output, which may exceed what the buffer could hold.
+     * 
+     */
+    template <typename... Arg>
+    size_t format_to(Arg&&... __args)
+    {
+        (apply(__args), ...);
+        stream.clear();
+        build(__args...);
+        if (_format != print_format::msgpack) stream << _end.__arg;
+        return stream.size();
     }
     PyPrint(sep __s = sep(" "), end __e = end("\n")) : _sep(__s), _end(__e) {}
+    PyPrint(print_buffer& __buffer) : stream(__buffer), _sep(" "), _end("\n") {}
 };
 
 inline void print()
 {
-    std::cout << std::endl;
+    std::string_view newline = "\n";
+    print_sink::get_default().write(&newline, 1);
 }
 template <typename... T>
 void print(T&&... __args)
 {
-    PyPrint python_print;
-    python_print.start_print(__args...);
-}
-template <typename... T>
-void print(sep __sep, T&&... __args)
-{
-    PyPrint python_print(__sep, end("\n"));
-    python_print.start_print(__args...);
+    print_buffer::claim __claim;
+    if (!__claim.nested())
+    {
+        PyPrint python_print;
+        python_print.start_print(__args...);
+    }
+    else
+    {
+        // reached from inside another print() on this thread, whose line is still being built in local()
+        print_buffer __own;
+        PyPrint python_print(__own);
+        python_print.start_print(__args...);
+    }
 }
+/**
+ * 
+ * @brief   Formats exactly like print(), end() included, into memory owned by the caller. No '\0' is added.
+ *          No state is shared, calls from any number of threads may run at once.
+ *          Arithmetic, string and container arguments allocate nothing, types printed through their own operator<<
+ *          are still formatted in a std::ostringstream, which allocates.
+ *          to() and streaming() have no effect.
+ * 
+ * @return  Length of the full output. When larger than __capacity, only the first __capacity bytes were written:
+ *          call again with a buffer of at least that size.
+ * 
+ */
 template <typename... T>
-void print(end __end, T&&... __args)
+size_t print_to(char* __buffer, size_t __capacity, T&&... __args)
 {
-    PyPrint python_print(sep(" "), __end);
-    python_print.start_print(__args...);
+    print_buffer __out(__buffer, __capacity);
+    PyPrint python_print(__out);
+    return python_print.format_to(__args...);
 }
+/**
+ * 
+ * @brief   Replaces the contents of __str with the output of print().
+ *          The string's existing capacity is used first, it only allocates when that is too small.
+ * 
+ * @return  Length of the output, equal to __str.size().
+ * 
+ */
 template <typename... T>
-void print(sep __sep, end __end, T&&... __args)
+size_t print_to(std::string& __str, T&&... __args)
 {
-    PyPrint python_print(__sep, __end);
-    python_print.start_print(__args...);
+    __str.resize(__str.capacity());
+    size_t __n = print_to(__str.data(), __str.size(), __args...);
+    if (__n > __str.size())
+    {
+        __str.resize(__n);
+        print_to(__str.data(), __n, __args...);
+    }
+    __str.resize(__n);
+    return __n;
 }
 
 #endif
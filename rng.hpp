@@ -66,8 +66,16 @@
  * 
  *          percentage:                 returns a true value for passed percentage,
  *                                      false value for failed percentage. Values
- *                                      below 1 always return false, value above 100
- *                                      always return true. 50 is a coin flip.
+ *                                      of 0 or below always return false, values of
+ *                                      100 or above always return true. 50 is a coin
+ *                                      flip. Fractional percentages are exact.
+ * 
+ * 
+ *          > random.percentage_mask()  || 0 overloads
+ * 
+ *          percentage:                 tries the percentage 64 times at once, bit i
+ *                                      of the returned uint64_t is set when roll i
+ *                                      succeeded.
  *          
  * 
  *          > random.UUID()             || 0 overloads
@@ -78,6 +86,27 @@
  *                                      Return value is a non-standard 64-bit int.
  *                                                                    
  * 
+ *      Counter-based generator:
+ * 
+ *          > Use 'PhiloxRandom random(seed, stream);'
+ * 
+ *          PhiloxRandom offers the same methods as Random but is
+ *          powered by a Philox4x32-10 engine. Draw #i of a stream
+ *          is a pure function of (seed, stream, i), so it can be
+ *          computed directly without stepping through draws 0..i-1.
+ * 
+ *          > Use 'random.at(i).method(argument);'
+ * 
+ *          at() positions the generator on draw #i, the result is
+ *          identical no matter which thread computes it, or how many
+ *          threads share the work.
+ * 
+ *          > random.gen.generate(first, count, out)
+ * 
+ *          Bulk path, computes 'count' raw 128-bit blocks for draws
+ *          first..first+count-1 several lanes at a time.
+ * 
+ * 
  *      ***          <---TO DO--->          ***
  * 
  *      Implement 128-bit UUID.
@@ -97,62 +126,249 @@
 #include    <random>
 #include    <chrono>
 #include    <cstdint>
+#include    <cstddef>
+#include    <array>
+#include    <limits>
+#include    <cmath>
+#include    <algorithm>
+#include    <type_traits>
 
 /**
  * 
- * @brief   Class for generating random numbers.
- *          See member functions Random() and instance() for more information how numbers are obtained.
- *          Class is a singleton instance.
- *          Create with this syntax: Random random = Random::instance();
+ * @brief   Philox4x32-10 counter-based engine.
+ *          Every 128-bit output block is a pure function of a 64-bit key and a 128-bit counter,
+ *          there is no sequential state to step through.
+ *          The key is the seed, the counter holds the draw index, the stream, and a sub-block index
+ *          used when one draw needs more than four 32-bit words.
+ *          Satisfies UniformRandomBitGenerator, so it can power the standard distributions.
  * 
- * @param   (empty)
- *          No argument defaults to system time seed for gen.
- *          Overloads with manual seed.
  * @param   seed
- *          Constructor takes a manual seed.
- *          Mostly for testing purposes.
+ *          64-bit key.
+ * @param   stream
+ *          Independent stream id, generators with the same seed and different streams never overlap.
  * 
  */
-class Random
+class philox4x32
 {
+public:
+    using result_type   = uint32_t;
+    using block_type    = std::array<uint32_t, 4>;
+    /**
+     * @brief Number of blocks computed side by side by generate().
+     */
+    static constexpr size_t lanes = 8;
 private:
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;
+    static constexpr uint32_t W1 = 0xBB67AE85;
+    uint32_t    key[2];
+    uint32_t    ctr[4];
+    block_type  buffer;
+    size_t      index = 4;
+    // ten rounds over L independent counters, stored as one array per word so the
+    // inner loop has no dependencies between lanes and can be vectorised by the compiler
+    template <size_t L>
+    static void rounds(uint32_t (&c)[4][L], uint32_t k0, uint32_t k1)
+    {
+        for (int r = 0; r < 10; r++)
+        {
+            for (size_t l = 0; l < L; l++)
+            {
+                uint64_t p0 = static_cast<uint64_t>(M0) * c[0][l];
+                uint64_t p1 = static_cast<uint64_t>(M1) * c[2][l];
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c[1][l] ^ k0;
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c[3][l] ^ k1;
+                c[1][l] = static_cast<uint32_t>(p1);
+                c[3][l] = static_cast<uint32_t>(p0);
+                c[0][l] = n0;
+                c[2][l] = n2;
+            }
+            k0 += W0; k1 += W1;
+        }
+    }
+    block_type block(const uint32_t (&counter)[4]) const
+    {
+        uint32_t c[4][1] = {{counter[0]}, {counter[1]}, {counter[2]}, {counter[3]}};
+        rounds(c, key[0], key[1]);
+        return {c[0][0], c[1][0], c[2][0], c[3][0]};
+    }
+    // sub-block and draw index form one 96-bit counter, the stream word is never touched
+    void increment()
+    {
+        if (++ctr[0] != 0) return;
+        if (++ctr[1] != 0) return;
+        ++ctr[2];
+    }
+public:
+    philox4x32(uint64_t seed = 0, uint32_t stream = 0)
+    {
+        this->seed(seed, stream);
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    void seed(uint64_t seed, uint32_t stream = 0)
+    {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+        ctr[3] = stream;
+        seek(0);
+    }
     /**
      * 
-     * @brief    Private constructor prevents creating more than one instance. Ensures singleton pattern, see getInstance() for explanation why singleton pattern is desired.
-     *           Obtains a seed via system time in nanoseconds, then seeds the Mersenne Twister engine, which powers all random functions within the class.
+     * @brief   Positions the engine on the first word of draw #counter.
+     *          Following calls to operator() continue through the sub-blocks of that draw.
+     * 
      */
-    Random()
+    void seek(uint64_t counter)
     {
-        gen.seed(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+        ctr[0] = 0;
+        ctr[1] = static_cast<uint32_t>(counter);
+        ctr[2] = static_cast<uint32_t>(counter >> 32);
+        index  = 4;
     }
-    Random(uint64_t seed)
+    /**
+     * 
+     * @brief   Returns the first block of draw #counter without changing the engine's position.
+     * 
+     * @param   counter
+     *          Draw index.
+     * 
+     * @return  Four 32-bit words.
+     * 
+     */
+    block_type at(uint64_t counter) const
     {
-        gen.seed(seed);
+        const uint32_t c[4] = {0, static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), ctr[3]};
+        return block(c);
     }
-public:
     /**
      * 
-     * @brief Creates an object with singleton pattern.
-     * This pattern ensures that the same seed is used throughout the program's run-time.
-     * Obtaining multiple seeds quickly, by seeding within a function, can produce the same value multiple times in a row.
-     * This is because the seed is obtained via system time in nanoseconds, but functions can be called multiple times per nanosecond.
-     * Therefore the same input will produce the same output, and any function called more than once per nanosecond will return the same value multiple times in a row.
+     * @brief   Computes the first block of draws first..first+count-1, 'lanes' draws at a time.
+     *          Equivalent to calling at() for every draw, but considerably faster.
+     * 
+     * @param   first
+     *          Index of the first draw.
+     * @param   count
+     *          Number of blocks to compute.
+     * @param   out
+     *          Destination, must have room for count blocks.
      * 
      */
-    static Random& instance()
+    void generate(uint64_t first, size_t count, block_type* out) const
     {
-        static Random instance;
-        return instance;    
+        while (count > 0)
+        {
+            uint32_t c[4][lanes];
+            for (size_t l = 0; l < lanes; l++)
+            {
+                uint64_t n = first + l;
+                c[0][l] = 0;
+                c[1][l] = static_cast<uint32_t>(n);
+                c[2][l] = static_cast<uint32_t>(n >> 32);
+                c[3][l] = ctr[3];
+            }
+            rounds(c, key[0], key[1]);
+            size_t done = count < lanes ? count : lanes;
+            for (size_t l = 0; l < done; l++) out[l] = {c[0][l], c[1][l], c[2][l], c[3][l]};
+            out += done; first += done; count -= done;
+        }
     }
-    static Random& instance(uint64_t seed)
+    result_type operator()()
     {
-        static Random instance(seed);
-        return instance;    
+        if (index == 4)
+        {
+            buffer = block(ctr);
+            increment();
+            index = 0;
+        }
+        return buffer[index++];
+    }
+    void discard(unsigned long long z)
+    {
+        while (z--) (*this)();
     }
+};
+
+/**
+ * 
+ * @brief   Shared implementation of the random methods.
+ *          Any UniformRandomBitGenerator can power them, see Random and PhiloxRandom.
+ * 
+ * @tparam  Engine
+ *          Type of the underlying engine.
+ * 
+ */
+template <class Engine>
+class basic_random
+{
+private:
+    // exact binary expansion of a probability __n / (100 * 2^__s), produced 64 bits at a time
+    // an exact comparison against a uniform draw only ever needs the next chunk when every previous chunk tied
+    struct threshold
+    {
+        uint64_t    n;
+        int         t;
+        bool        tail = false;
+        uint64_t    r    = 0;
+        template <typename T> threshold(T __x)
+        {
+            if constexpr (std::is_integral_v<T>)
+            {
+                n = static_cast<uint64_t>(__x);
+                t = 0;
+            }
+            else
+            {
+                static_assert(std::numeric_limits<T>::digits <= 64, "percentage() type has more than 64 significant bits");
+                int e;
+                T f = std::frexp(__x, &e);
+                n = static_cast<uint64_t>(std::ldexp(f, std::numeric_limits<T>::digits));
+                t = e - std::numeric_limits<T>::digits;
+            }
+        }
+        uint64_t next()
+        {
+            t += 64;
+            if (t <= 0) return (-t >= 64) ? 0 : (n / 100) >> -t;
+            if (tail)
+            {
+                __uint128_t w = static_cast<__uint128_t>(r) << 64;
+                r = static_cast<uint64_t>(w % 100);
+                return static_cast<uint64_t>(w / 100);
+            }
+            tail = true;
+            if (t == 64 && n <= 100)
+            {
+                // whole percentages: 2^64 = 100 * 184467440737095516 + 16
+                r = n * 16 % 100;
+                return n * 184467440737095516ULL + n * 16 / 100;
+            }
+            __uint128_t w = static_cast<__uint128_t>(n) << t;
+            r = static_cast<uint64_t>(w % 100);
+            return static_cast<uint64_t>(w / 100);
+        }
+    };
+    // 64 uniform bits straight from the engine, bypassing the distributions
+    uint64_t raw64()
+    {
+        static_assert(Engine::min() == 0, "engine must produce full-range words");
+        if constexpr (Engine::max() == std::numeric_limits<uint64_t>::max())
+        {
+            return gen();
+        }
+        else
+        {
+            static_assert(Engine::max() == std::numeric_limits<uint32_t>::max(), "engine must produce 32 or 64-bit words");
+            uint64_t hi = gen();
+            return (hi << 32) | gen();
+        }
+    }
+public:
     /**
-     * @brief An object of Marsenne Twister type. 
+     * @brief The engine powering every method.
      */
-    std::mt19937 gen;
+    Engine gen;
     /**
      * @name Uniform Distribution Functions
      */
@@ -366,6 +582,7 @@ public:
     /**
      * 
      * @brief   Tries a percentage chance, argument determines chance to succeed.
+     *          Compares raw engine output against an integer threshold, no distribution is involved.
      * 
      * @tparam  T
      *          Determines parameter data type.
@@ -373,6 +590,7 @@ public:
      * @param   __x
      *          Percentage to try.
      *          Higher values succeed more often.
+     *          Fractional percentages are honoured exactly, 12.5 succeeds exactly one time in eight.
      * 
      * @return  Boolean value.
      *          True is a successful roll, false is a failed roll.
@@ -383,9 +601,61 @@ public:
      */
     template <typename T> bool percentage(T __x)
     {
-            std::max(T(0), std::min(T(100), __x));
-            T randomNumber = number(1, 100);
-            return randomNumber < __x;
+        __x = std::max(T(0), std::min(T(100), __x));
+        if (__x <= T(0))    return false;
+        if (__x >= T(100))  return true;
+        threshold __t(__x);
+        for (;;)
+        {
+            uint64_t __c = __t.next();
+            uint64_t __u = raw64();
+            if (__u != __c) return __u < __c;
+        }
+    }
+    /**
+     * 
+     * @brief   Tries 64 independent percentage chances at once.
+     *          The 64 draws are bit-sliced: each engine word supplies one bit of every draw,
+     *          and draws are settled from the most significant bit down, so about eight words are consumed per call.
+     * 
+     * @tparam  T
+     *          Determines parameter data type.
+     * 
+     * @param   __x
+     *          Percentage to try, see percentage().
+     * 
+     * @return  uint64_t mask.
+     *          Bit i is set when roll i succeeded.
+     * 
+     * @warning Numbers below 0 or above 100 will be clamped to within this range, clamped values are not random.
+     * 
+     */
+    template <typename T> uint64_t percentage_mask(T __x)
+    {
+        __x = std::max(T(0), std::min(T(100), __x));
+        if (__x <= T(0))    return 0;
+        if (__x >= T(100))  return ~uint64_t(0);
+        threshold __t(__x);
+        uint64_t __less = 0;
+        uint64_t __open = ~uint64_t(0);
+        for (;;)
+        {
+            uint64_t __c = __t.next();
+            for (int __b = 63; __b >= 0; __b--)
+            {
+                uint64_t __r = raw64();
+                if ((__c >> __b) & 1)
+                {
+                    __less |= __open & ~__r;
+                    __open &= __r;
+                }
+                else
+                {
+                    __open &= ~__r;
+                }
+                if (__open == 0) return __less;
+            }
+        }
     }
     /**
      * @name Unique ID Generator Functions
@@ -409,4 +679,97 @@ public:
     }
 };
 
+/**
+ * 
+ * @brief   Class for generating random numbers.
+ *          See member functions Random() and instance() for more information how numbers are obtained.
+ *          Class is a singleton instance.
+ *          Create with this syntax: Random random = Random::instance();
+ *          Powered by a Marsenne Twister engine.
+ * 
+ * @param   (empty)
+ *          No argument defaults to system time seed for gen.
+ *          Overloads with manual seed.
+ * @param   seed
+ *          Constructor takes a manual seed.
+ *          Mostly for testing purposes.
+ * 
+ */
+class Random : public basic_random<std::mt19937>
+{
+private:
+    /**
+     * 
+     * @brief    Private constructor prevents creating more than one instance. Ensures singleton pattern, see getInstance() for explanation why singleton pattern is desired.
+     *           Obtains a seed via system time in nanoseconds, then seeds the Mersenne Twister engine, which powers all random functions within the class.
+     */
+    Random()
+    {
+        gen.seed(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    }
+    Random(uint64_t seed)
+    {
+        gen.seed(seed);
+    }
+public:
+    /**
+     * 
+     * @brief Creates an object with singleton pattern.
+     * This pattern ensures that the same seed is used throughout the program's run-time.
+     * Obtaining multiple seeds quickly, by seeding within a function, can produce the same value multiple times in a row.
+     * This is because the seed is obtained via system time in nanoseconds, but functions can be called multiple times per nanosecond.
+     * Therefore the same input will produce the same output, and any function called more than once per nanosecond will return the same value multiple times in a row.
+     * 
+     */
+    static Random& instance()
+    {
+        static Random instance;
+        return instance;    
+    }
+    static Random& instance(uint64_t seed)
+    {
+        static Random instance(seed);
+        return instance;    
+    }
+};
+
+/**
+ * 
+ * @brief   Class for generating reproducible random numbers in parallel.
+ *          Powered by a Philox4x32-10 counter-based engine, see philox4x32.
+ *          Not a singleton, create one object per thread with the same seed and stream,
+ *          then use at() to pick the draw each thread computes.
+ * 
+ * @param   seed
+ *          Seed shared by every thread.
+ * @param   stream
+ *          Optional (default: 0).
+ *          Independent stream id.
+ * 
+ */
+class PhiloxRandom : public basic_random<philox4x32>
+{
+public:
+    PhiloxRandom(uint64_t seed, uint32_t stream = 0)
+    {
+        gen.seed(seed, stream);
+    }
+    /**
+     * 
+     * @brief   Positions the generator on draw #counter of its stream.
+     *          The next method called returns the same value whichever thread calls it.
+     * 
+     * @param   counter
+     *          Draw index.
+     * 
+     * @return  Reference to the generator, so calls can be chained: random.at(i).number(1, 6).
+     * 
+     */
+    PhiloxRandom& at(uint64_t counter)
+    {
+        gen.seek(counter);
+        return *this;
+    }
+};
+
 #endif
\ No newline at end of file
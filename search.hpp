@@ -0,0 +1,719 @@
+/*
+ *
+ *      Search indexes for read-heavy lookups in large sorted data.
+ *
+ *      binary_search() in functions.hpp sorts the vector on every call.
+ *      The classes here are built once, own a sorted copy of the data
+ *      and answer any number of lookups without touching it again.
+ *
+ *      search_index:
+ *          > Eytzinger (BFS) layout: the sorted values are stored in the
+ *          order a binary search visits them, root first, so the first
+ *          levels of every search share the same few cache lines.
+ *          > Branchless descent, one comparison and one shift per level,
+ *          no mispredictions.
+ *          > Prefetches the cache line holding the node four levels
+ *          down, the memory latency of the next levels overlaps the
+ *          comparisons of the current ones.
+ *          > Positions are size_t ranks in sorted order, lower_bound()
+ *          and upper_bound() as in <algorithm>.
+ *          > Batches: lower_bound(keys, count, out) and friends search a
+ *          whole array of keys, sixteen at a time in lockstep, so the
+ *          cache misses of sixteen searches are in flight together
+ *          instead of one after another.
+ *
+ *      interpolation_search():
+ *          > for a vector that is already sorted, no index to build.
+ *          > probes where the key should be if the values are evenly
+ *          spread, about log2(log2(n)) probes on IDs and timestamps.
+ *          > a guard probe next to each guess brackets the key, a guess
+ *          that fails to halve the range hands over to binary search,
+ *          skewed data costs a few probes more than std::lower_bound.
+ *
+ *      learned_index:
+ *          > piecewise-linear model of the sorted values: each segment
+ *          predicts a key's position to within epsilon, the segments
+ *          are modelled the same way, level on level.
+ *          > a lookup reads one line per level and gallops out from the
+ *          prediction a cache line at a time, counting the last bracket
+ *          with SIMD compares: two or three lines on the data where
+ *          binary search on 10^8 keys misses on most of its 27 probes.
+ *          > data too skewed for short lines to fit falls back to a
+ *          search_index, modelled() tells which one answers.
+ *
+ *
+ */
+
+#ifndef     SEARCH
+#define     SEARCH
+
+#include    <algorithm>
+#include    <cmath>
+#include    <cstddef>
+#include    <cstdint>
+#include    <cstring>
+#include    <iterator>
+#include    <limits>
+#include    <memory>
+#include    <new>
+#include    <type_traits>
+#include    <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include    <immintrin.h>
+#endif
+
+/**
+ *
+ * @brief   Static sorted index in Eytzinger layout.
+ *          Building sorts a copy of the values, O(n log n) once, lookups are O(log n) with no branches to mispredict.
+ *          The index cannot be modified after it is built, build a new one instead.
+ *
+ * @tparam  T
+ *          Key type, trivially copyable and ordered by operator<.
+ *
+ */
+template <typename T>
+class search_index
+{
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "search_index: T must be trivially copyable");
+    struct aligned_delete
+    {
+        void operator()(T* __p) const
+        {
+            ::operator delete(__p, std::align_val_t(64));
+        }
+    };
+    // 1 based, tree[1] is the root and the children of k are 2k and 2k + 1
+    std::unique_ptr<T[], aligned_delete>    tree;
+    size_t                                  n       = 0;
+    unsigned                                levels  = 0;
+    // with tree 64-byte aligned, the 2^4 descendants four levels below k share one cache line when T fits 4 bytes
+    static constexpr size_t                 stride  = sizeof(T) <= 64 ? 64 / sizeof(T) : 1;
+
+    static unsigned floor_log2(size_t __x)
+    {
+        return 63 - static_cast<unsigned>(__builtin_clzll(static_cast<unsigned long long>(__x)));
+    }
+    // in-order traversal of the implicit tree hands out the sorted values, O(n)
+    size_t fill(const T* __sorted, size_t __i, size_t __k)
+    {
+        if (__k > n) return __i;
+        __i = fill(__sorted, __i, 2 * __k);
+        tree[__k] = __sorted[__i++];
+        return fill(__sorted, __i, 2 * __k + 1);
+    }
+    // sorted position of node __k, O(1): its in-order rank in the full tree of the same height,
+    // less the missing last-level nodes that would have come before it
+    size_t rank_of(size_t __k) const
+    {
+        unsigned __depth    = floor_log2(__k);
+        unsigned __below    = levels - 1 - __depth;
+        size_t __offset     = 2 * (__k - (size_t(1) << __depth)) + 1;
+        size_t __rank       = (__offset << __below) - 1;
+        if (__below == 0) return __rank;
+        size_t __leaves     = n - ((size_t(1) << (levels - 1)) - 1);
+        size_t __before     = __offset << (__below - 1);
+        return __rank - (__before > __leaves ? __before - __leaves : 0);
+    }
+    enum class query { lower, upper, find };
+    static constexpr size_t group = 16;
+    template <query __Q>
+    static bool goes_right(const T& __node, const T& __key)
+    {
+        return __Q == query::upper ? !(__key < __node) : __node < __key;
+    }
+    // turns the index a descent ended on into the answer:
+    // strip the trailing right turns and the last left turn, 0 if the search only went right
+    template <query __Q>
+    size_t answer(size_t __k, const T& __key) const
+    {
+        __k >>= __builtin_ffsll(static_cast<long long>(~__k));
+        if (__Q == query::find && (__k == 0 || __key < tree[__k])) return npos;
+        return __k == 0 ? n : rank_of(__k);
+    }
+    // sixteen descents in lockstep: every level but the last is full, so all of them take the same number of steps
+    // on the last level a descent whose node is missing keeps its index, as the single-key loop would
+    template <query __Q>
+    void descend_group(const T* __keys, size_t* __out) const
+    {
+        size_t __k[group];
+        for (size_t __g = 0; __g < group; __g++) __k[__g] = 1;
+        for (unsigned __level = 0; __level + 1 < levels; __level++)
+        {
+            for (size_t __g = 0; __g < group; __g++)
+            {
+                __builtin_prefetch(tree.get() + __k[__g] * stride);
+                __k[__g] = 2 * __k[__g] + goes_right<__Q>(tree[__k[__g]], __keys[__g]);
+            }
+        }
+        for (size_t __g = 0; __g < group; __g++)
+        {
+            bool __exists = __k[__g] <= n;
+            bool __right = goes_right<__Q>(tree[__exists ? __k[__g] : 0], __keys[__g]);
+            __k[__g] = __exists ? 2 * __k[__g] + __right : __k[__g];
+            __out[__g] = answer<__Q>(__k[__g], __keys[__g]);
+        }
+    }
+    template <query __Q>
+    void descend_batch(const T* __keys, size_t __count, size_t* __out) const
+    {
+        if (n == 0)
+        {
+            std::fill(__out, __out + __count, __Q == query::find ? npos : 0);
+            return;
+        }
+        size_t __i = 0;
+        for (; __i + group <= __count; __i += group) descend_group<__Q>(__keys + __i, __out + __i);
+        __out += __i;
+        for (const T* __key = __keys + __i; __key != __keys + __count; __key++)
+        {
+            *__out++ = __Q == query::find ? find(*__key) : descend<__Q == query::upper>(*__key);
+        }
+    }
+    // the descent goes right while Less(node, key), the answer is the last node where it went left
+    template <bool __Upper>
+    size_t descend(const T& __key) const
+    {
+        size_t __k = 1;
+        while (__k <= n)
+        {
+            __builtin_prefetch(tree.get() + __k * stride);
+            bool __right = __Upper ? !(__key < tree[__k]) : tree[__k] < __key;
+            __k = 2 * __k + __right;
+        }
+        return answer<__Upper ? query::upper : query::lower>(__k, __key);
+    }
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    search_index() {}
+    /**
+     *
+     * @brief   Builds the index from a copy of the values, the caller's data is not modified.
+     *
+     * @param   __values
+     *          Values in any order, duplicates allowed.
+     *
+     */
+    explicit search_index(std::vector<T> __values)
+    {
+        std::sort(__values.begin(), __values.end());
+        build(__values.data(), __values.size());
+    }
+    /**
+     *
+     * @brief   Builds the index from a range that is already sorted ascending, skipping the sort.
+     *
+     */
+    template <typename __Iter>
+    search_index(__Iter __first, __Iter __last, bool __sorted)
+    {
+        std::vector<T> __values(__first, __last);
+        if (!__sorted) std::sort(__values.begin(), __values.end());
+        build(__values.data(), __values.size());
+    }
+    size_t size() const
+    {
+        return n;
+    }
+    /**
+     * @brief First sorted position whose value is not less than __key, size() if there is none.
+     */
+    size_t lower_bound(const T& __key) const
+    {
+        return descend<false>(__key);
+    }
+    /**
+     * @brief First sorted position whose value is greater than __key, size() if there is none.
+     */
+    size_t upper_bound(const T& __key) const
+    {
+        return descend<true>(__key);
+    }
+    /**
+     *
+     * @brief   Sorted position of the first value equal to __key.
+     *
+     * @return  The position as size_t, or npos if __key is not in the index.
+     *
+     */
+    size_t find(const T& __key) const
+    {
+        size_t __k = 1;
+        while (__k <= n)
+        {
+            __builtin_prefetch(tree.get() + __k * stride);
+            __k = 2 * __k + (tree[__k] < __key);
+        }
+        return answer<query::find>(__k, __key);
+    }
+    bool contains(const T& __key) const
+    {
+        return find(__key) != npos;
+    }
+    /**
+     *
+     * @brief   lower_bound() of every key in a batch, much faster than one call per key on large indexes.
+     *
+     * @param   __keys
+     *          __count keys, in any order.
+     *
+     * @param   __out
+     *          Caller-provided room for __count positions, __out[i] answers __keys[i].
+     *
+     */
+    void lower_bound(const T* __keys, size_t __count, size_t* __out) const
+    {
+        descend_batch<query::lower>(__keys, __count, __out);
+    }
+    /**
+     * @brief upper_bound() of every key in a batch, see lower_bound(keys, count, out).
+     */
+    void upper_bound(const T* __keys, size_t __count, size_t* __out) const
+    {
+        descend_batch<query::upper>(__keys, __count, __out);
+    }
+    /**
+     * @brief find() of every key in a batch, npos for the keys that are absent.
+     */
+    void find(const T* __keys, size_t __count, size_t* __out) const
+    {
+        descend_batch<query::find>(__keys, __count, __out);
+    }
+private:
+    void build(const T* __sorted, size_t __count)
+    {
+        n       = __count;
+        levels  = n == 0 ? 0 : floor_log2(n) + 1;
+        tree.reset(static_cast<T*>(::operator new((n + 1) * sizeof(T), std::align_val_t(64))));
+        // tree[0] is never a node, lockstep descents read it in place of a missing one
+        if (n > 0) tree[0] = __sorted[0];
+        fill(__sorted, 0, 1);
+    }
+};
+
+/**
+ *
+ * @brief   Distance from __base up to __x as a double, 0 if __x is not above __base.
+ *          Integers are subtracted before converting, large 64-bit keys such as timestamps keep their precision.
+ *
+ */
+template <typename T>
+double __search_offset(const T& __x, const T& __base)
+{
+    if (!(__base < __x)) return 0;
+    if constexpr (std::is_integral<T>::value)
+    {
+        using __U = typename std::make_unsigned<T>::type;
+        return static_cast<double>(static_cast<__U>(static_cast<__U>(__x) - static_cast<__U>(__base)));
+    }
+    else return static_cast<double>(__x) - static_cast<double>(__base);
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// bit i set where lane i of a is less than lane i of b, __V is __m256i or __m128i holding T in every lane
+template <typename T, typename __V>
+int __search_lanes_less(__V __a, __V __b)
+{
+    constexpr bool __wide = sizeof(__V) == 32;
+    if constexpr (std::is_same<T, float>::value)
+    {
+        if constexpr (__wide) return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_castsi256_ps(__a), _mm256_castsi256_ps(__b), _CMP_LT_OQ));
+        else return _mm_movemask_ps(_mm_cmplt_ps(_mm_castsi128_ps(__a), _mm_castsi128_ps(__b)));
+    }
+    else if constexpr (std::is_same<T, double>::value)
+    {
+        if constexpr (__wide) return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_castsi256_pd(__a), _mm256_castsi256_pd(__b), _CMP_LT_OQ));
+        else return _mm_movemask_pd(_mm_cmplt_pd(_mm_castsi128_pd(__a), _mm_castsi128_pd(__b)));
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        // unsigned keys compare as signed once their top bits are flipped
+        constexpr int __bias = std::is_signed<T>::value ? 0 : static_cast<int>(0x80000000u);
+        if constexpr (__wide)
+        {
+            const __m256i __flip = _mm256_set1_epi32(__bias);
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_xor_si256(__b, __flip), _mm256_xor_si256(__a, __flip))));
+        }
+        else
+        {
+            const __m128i __flip = _mm_set1_epi32(__bias);
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(_mm_xor_si128(__a, __flip), _mm_xor_si128(__b, __flip))));
+        }
+    }
+    else
+    {
+        constexpr long long __bias = std::is_signed<T>::value ? 0 : static_cast<long long>(0x8000000000000000ull);
+        if constexpr (__wide)
+        {
+            const __m256i __flip = _mm256_set1_epi64x(__bias);
+            return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_xor_si256(__b, __flip), _mm256_xor_si256(__a, __flip))));
+        }
+        else
+        {
+            const __m128i __flip = _mm_set1_epi64x(__bias);
+            return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(_mm_xor_si128(__b, __flip), _mm_xor_si128(__a, __flip))));
+        }
+    }
+}
+#endif
+
+/**
+ *
+ * @brief   Counts the values of a short sorted run that are below __key, or not above it when __Upper.
+ *          All the values are compared, no branches depend on them: the run is a few cache lines read front to back.
+ *          AVX2 compares 32 bytes at a time, SSE2 16 (64-bit integers need SSE4.2), anything else a value at a time.
+ *
+ */
+template <bool __Upper, typename T>
+size_t __search_count_below(const T* __run, size_t __len, const T& __key)
+{
+    size_t __count  = 0;
+    size_t __i      = 0;
+    constexpr bool __float  = std::is_same<T, float>::value || std::is_same<T, double>::value;
+    constexpr bool __lanes  = __float || (std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8));
+#ifdef      __AVX2__
+    if constexpr (__lanes)
+    {
+        constexpr size_t __width = 32 / sizeof(T);
+        typename std::conditional<sizeof(T) == 4, int, long long>::type __bits;
+        std::memcpy(&__bits, &__key, sizeof(T));
+        const __m256i __k = sizeof(T) == 4 ? _mm256_set1_epi32(static_cast<int>(__bits)) : _mm256_set1_epi64x(__bits);
+        for (; __i + __width <= __len; __i += __width)
+        {
+            __m256i __v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(__run + __i));
+            if (__Upper) __count += __width - __builtin_popcount(__search_lanes_less<T>(__k, __v));
+            else __count += __builtin_popcount(__search_lanes_less<T>(__v, __k));
+        }
+    }
+#elif defined(__SSE2__)
+#ifdef      __SSE4_2__
+    constexpr bool __sse = __lanes;
+#else
+    constexpr bool __sse = __lanes && (sizeof(T) == 4 || __float);
+#endif
+    if constexpr (__sse)
+    {
+        constexpr size_t __width = 16 / sizeof(T);
+        typename std::conditional<sizeof(T) == 4, int, long long>::type __bits;
+        std::memcpy(&__bits, &__key, sizeof(T));
+        const __m128i __k = sizeof(T) == 4 ? _mm_set1_epi32(static_cast<int>(__bits)) : _mm_set1_epi64x(__bits);
+        for (; __i + __width <= __len; __i += __width)
+        {
+            __m128i __v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(__run + __i));
+            if (__Upper) __count += __width - __builtin_popcount(__search_lanes_less<T>(__k, __v));
+            else __count += __builtin_popcount(__search_lanes_less<T>(__v, __k));
+        }
+    }
+#endif
+    (void)__lanes;
+    for (; __i < __len; __i++) __count += __Upper ? !(__key < __run[__i]) : __run[__i] < __key;
+    return __count;
+}
+
+/**
+ *
+ * @brief   Interpolation search: guesses where __key sits from its value instead of halving.
+ *          Each round probes the guess, then a guard sqrt(range) away on the side the answer is on,
+ *          on evenly spread keys (IDs, timestamps) the two brackets it, n shrinks to sqrt(n) and it needs O(log log n) rounds.
+ *          A round that fails to halve the range hands the rest to binary search, skewed data costs a few probes more than std::lower_bound.
+ *          The last few values are counted with __search_count_below().
+ *
+ * @tparam  T
+ *          Arithmetic key type.
+ *
+ * @param   __sorted
+ *          Values sorted ascending. Unlike binary_search() in functions.hpp the vector is not sorted here.
+ *
+ * @return  The lower_bound() position as size_t, __sorted.size() if every value is less than __key.
+ *
+ */
+template <typename T>
+size_t interpolation_search(const std::vector<T>& __sorted, const T& __key)
+{
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "interpolation_search: T must be arithmetic");
+    // below this many values a scan touches no more cache lines than another probe would
+    constexpr size_t __scan = 64 / sizeof(T) < 8 ? 8 : 64 / sizeof(T);
+    const T* __a    = __sorted.data();
+    size_t __lo     = 0;
+    size_t __hi     = __sorted.size();
+    // the answer is in [lo, hi]: a[lo - 1] < key and key <= a[hi]
+    while (__hi - __lo > __scan)
+    {
+        if (!(__a[__lo] < __key)) return __lo;
+        if (__a[__hi - 1] < __key) return __hi;
+        size_t __before = __hi - __lo;
+        size_t __guard  = std::max(static_cast<size_t>(std::sqrt(static_cast<double>(__before))), __scan);
+        double __fraction = __search_offset(__key, __a[__lo]) / __search_offset(__a[__hi - 1], __a[__lo]);
+        size_t __probe  = __lo + static_cast<size_t>(__fraction * static_cast<double>(__hi - 1 - __lo));
+        __probe         = std::min(__probe, __hi - 1);
+        if (__a[__probe] < __key)
+        {
+            __lo = __probe + 1;
+            if (__probe + __guard < __hi && !(__a[__probe + __guard] < __key)) __hi = __probe + __guard;
+            else if (__probe + __guard < __hi) __lo = __probe + __guard + 1;
+        }
+        else
+        {
+            __hi = __probe;
+            if (__probe > __lo + __guard && __a[__probe - __guard] < __key) __lo = __probe - __guard + 1;
+            else if (__probe > __lo + __guard) __hi = __probe - __guard;
+        }
+        if (__hi - __lo > __before / 2) break;
+    }
+    if (__hi - __lo <= __scan) return __lo + __search_count_below<false>(__a + __lo, __hi - __lo, __key);
+    // binary search over the whole vector rather than [lo, hi): it probes the same midpoints as every other lookup,
+    // the first ones stay cached, and a midpoint outside [lo, hi) is already known and not read
+    size_t __first  = 0;
+    size_t __len    = __sorted.size();
+    while (__len > 0)
+    {
+        size_t __half   = __len / 2;
+        size_t __mid    = __first + __half;
+        bool __right    = __mid < __lo || (__mid < __hi && __a[__mid] < __key);
+        __first         = __right ? __mid + 1 : __first;
+        __len           = __right ? __len - __half - 1 : __half;
+    }
+    return __first;
+}
+
+/**
+ *
+ * @brief   Static sorted index with a piecewise-linear model of where each key sits.
+ *          The sorted values are split into segments, each with a line that predicts a key's position within __epsilon.
+ *          The segments' first keys are modelled the same way, level on level, until one segment is left.
+ *          A lookup walks down the levels, each time galloping out from the prediction and counting the last bracket,
+ *          so it touches a few cache lines per level instead of one per halving.
+ *          When the data is too skewed for lines to fit (segments averaging fewer than 2 __epsilon values)
+ *          the index falls back to a search_index over the same values.
+ *
+ * @tparam  T
+ *          Arithmetic key type.
+ *
+ */
+template <typename T>
+class learned_index
+{
+private:
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "learned_index: T must be arithmetic");
+    struct line
+    {
+        double  slope;
+        size_t  base;
+    };
+    // the segments of one level: keys[i] is the first key of segment i, lines[i] predicts positions from base onwards
+    struct level
+    {
+        std::vector<T>      keys;
+        std::vector<line>   lines;
+    };
+    std::vector<T>      data;
+    // levels[0] predicts positions in data, levels[i] positions in levels[i - 1].keys
+    std::vector<level>  levels;
+    search_index<T>     fallback;
+    size_t              epsilon = 0;
+    bool                learned = false;
+    static constexpr size_t line_values = 64 / sizeof(T) < 4 ? 4 : 64 / sizeof(T);
+
+    // greedy fit: a segment grows while some line through its first point stays within epsilon of every later one
+    // only the first of equal values is fitted, a run of duplicates longer than epsilon is resolved by galloping
+    level fit(const std::vector<T>& __sorted) const
+    {
+        level __out;
+        const double __e = static_cast<double>(epsilon);
+        double __low    = 0;
+        double __high   = 0;
+        for (size_t __i = 0; __i < __sorted.size(); __i++)
+        {
+            if (__i > 0 && !(__sorted[__i - 1] < __sorted[__i])) continue;
+            if (!__out.keys.empty())
+            {
+                double __dx     = __search_offset(__sorted[__i], __out.keys.back());
+                double __dy     = static_cast<double>(__i - __out.lines.back().base);
+                double __l      = std::max(__low, (__dy - __e) / __dx);
+                double __h      = std::min(__high, (__dy + __e) / __dx);
+                if (__l <= __h)
+                {
+                    __low   = __l;
+                    __high  = __h;
+                    continue;
+                }
+                __out.lines.back().slope = __low + (__high - __low) / 2;
+            }
+            __out.keys.push_back(__sorted[__i]);
+            __out.lines.push_back({0, __i});
+            __low   = 0;
+            __high  = std::numeric_limits<double>::infinity();
+        }
+        if (!__out.lines.empty() && __high != std::numeric_limits<double>::infinity()) __out.lines.back().slope = __low + (__high - __low) / 2;
+        return __out;
+    }
+    // lower_bound (upper_bound when __Upper) of __key in sorted[0, count), galloping out from __guess
+    // a cache line's worth of values first, doubling each step: the answer is within epsilon, log2(epsilon / line) + 1 steps at most
+    // the last bracket is counted when it is a few cache lines, past a long run of duplicates it is halved instead
+    template <bool __Upper>
+    size_t gallop(const T* __sorted, size_t __count, double __guess, const T& __key) const
+    {
+        auto __below    = [&](const T& __x) { return __Upper ? !(__key < __x) : __x < __key; };
+        size_t __at     = __guess <= 0 ? 0 : __guess >= static_cast<double>(__count) ? __count : static_cast<size_t>(__guess);
+        size_t __step   = line_values;
+        size_t __lo;
+        size_t __hi;
+        // which way to gallop is a coin toss to the branch predictor, both neighbouring lines are fetched before it guesses
+        __builtin_prefetch(__sorted + (__at > __step ? __at - __step : 0));
+        __builtin_prefetch(__sorted + std::min(__at + __step, __count));
+        // the answer is in [lo, hi]: sorted[lo - 1] is below key, sorted[hi] is not
+        if (__at < __count && __below(__sorted[__at]))
+        {
+            __lo = __at + 1;
+            while (true)
+            {
+                __hi = std::min(__lo + __step, __count);
+                if (__hi == __count || !__below(__sorted[__hi])) break;
+                __lo    = __hi + 1;
+                __step  *= 2;
+            }
+        }
+        else
+        {
+            __hi = __at;
+            while (true)
+            {
+                __lo = __hi > __step ? __hi - __step : 0;
+                if (__lo == 0 || __below(__sorted[__lo - 1])) break;
+                __hi    = __lo - 1;
+                __step  *= 2;
+            }
+        }
+        if (__hi - __lo > 4 * line_values)
+        {
+            return (__Upper ? std::upper_bound(__sorted + __lo, __sorted + __hi, __key) : std::lower_bound(__sorted + __lo, __sorted + __hi, __key)) - __sorted;
+        }
+        return __lo + __search_count_below<__Upper>(__sorted + __lo, __hi - __lo, __key);
+    }
+    template <bool __Upper>
+    size_t search(const T& __key) const
+    {
+        if (!learned) return __Upper ? fallback.upper_bound(__key) : fallback.lower_bound(__key);
+        if (data.empty()) return 0;
+        size_t __segment = 0;
+        for (size_t __l = levels.size(); __l-- > 0;)
+        {
+            const line& __line  = levels[__l].lines[__segment];
+            double __guess      = static_cast<double>(__line.base) + __line.slope * __search_offset(__key, levels[__l].keys[__segment]);
+            if (__l == 0) return gallop<__Upper>(data.data(), data.size(), __guess, __key);
+            // the segment below is the last one starting at or before key
+            const std::vector<T>& __keys = levels[__l - 1].keys;
+            size_t __after  = gallop<true>(__keys.data(), __keys.size(), __guess, __key);
+            __segment       = __after > 0 ? __after - 1 : 0;
+        }
+        return 0;
+    }
+    void build(std::vector<T>&& __sorted)
+    {
+        epsilon = std::max<size_t>(epsilon, 1);
+        levels.push_back(fit(__sorted));
+        // segments shorter than 2 epsilon narrow the search less than a level costs to read
+        if (levels[0].keys.size() > 1 && levels[0].keys.size() > __sorted.size() / (2 * epsilon))
+        {
+            levels.clear();
+            fallback = search_index<T>(__sorted.begin(), __sorted.end(), true);
+            return;
+        }
+        while (levels.back().keys.size() > 1) levels.push_back(fit(levels.back().keys));
+        data    = std::move(__sorted);
+        learned = true;
+    }
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    learned_index() {}
+    /**
+     *
+     * @brief   Builds the index from a copy of the values, the caller's data is not modified.
+     *
+     * @param   __values
+     *          Values in any order, duplicates allowed.
+     *
+     * @param   __epsilon
+     *          Largest distance between a predicted and a true position.
+     *          Larger means fewer segments and levels but longer gallops on each.
+     *
+     */
+    explicit learned_index(std::vector<T> __values, size_t __epsilon = 32) : epsilon(__epsilon)
+    {
+        std::sort(__values.begin(), __values.end());
+        build(std::move(__values));
+    }
+    /**
+     *
+     * @brief   Builds the index from a range that is already sorted ascending, skipping the sort.
+     *
+     */
+    template <typename __Iter>
+    learned_index(__Iter __first, __Iter __last, bool __sorted, size_t __epsilon = 32) : epsilon(__epsilon)
+    {
+        std::vector<T> __values(__first, __last);
+        if (!__sorted) std::sort(__values.begin(), __values.end());
+        build(std::move(__values));
+    }
+    size_t size() const
+    {
+        return learned ? data.size() : fallback.size();
+    }
+    /**
+     * @brief False if the data was too skewed to model and lookups go to a search_index instead.
+     */
+    bool modelled() const
+    {
+        return learned;
+    }
+    /**
+     * @brief Number of levels of segments, 0 when not modelled().
+     */
+    size_t depth() const
+    {
+        return levels.size();
+    }
+    /**
+     * @brief Number of segments modelling the data itself, 0 when not modelled().
+     */
+    size_t segments() const
+    {
+        return levels.empty() ? 0 : levels[0].keys.size();
+    }
+    /**
+     * @brief First sorted position whose value is not less than __key, size() if there is none.
+     */
+    size_t lower_bound(const T& __key) const
+    {
+        return search<false>(__key);
+    }
+    /**
+     * @brief First sorted position whose value is greater than __key, size() if there is none.
+     */
+    size_t upper_bound(const T& __key) const
+    {
+        return search<true>(__key);
+    }
+    /**
+     *
+     * @brief   Sorted position of the first value equal to __key.
+     *
+     * @return  The position as size_t, or npos if __key is not in the index.
+     *
+     */
+    size_t find(const T& __key) const
+    {
+        if (!learned) return fallback.find(__key);
+        size_t __at = search<false>(__key);
+        return __at == data.size() || __key < data[__at] ? npos : __at;
+    }
+    bool contains(const T& __key) const
+    {
+        return find(__key) != npos;
+    }
+};
+
+#endif
@@ -0,0 +1,310 @@
+#ifndef     SKIP_LIST
+#define     SKIP_LIST 1
+
+#include    <iostream>
+#include    <cstdint>
+#include    <new>
+#include    <stdexcept>
+#include    <type_traits>
+#include    <utility>
+#include    "node_pool.hpp"
+
+// same interface as linked_list, plus at(), but positions are found through an indexable skip list:
+// every link also stores its width, the number of elements it steps over,
+// so insert(), remove_index() and at() run in expected O(log n) instead of walking from the start
+// each node gets a random height, one extra level with probability 1/4, about 1.33 links per element on average
+
+template <class T, template <class> class Pool = node_pool>
+class skip_list
+{
+private:
+    static constexpr unsigned max_level = 32;
+    struct Link
+    {
+        Link*   next;
+        size_t  width;
+    };
+    struct Node
+    {
+        T           data;
+        unsigned    level;
+        Node(T d, unsigned l) : data(std::move(d)), level(l) {}
+    };
+    // a node's links follow it in the same allocation, the links are what the list points at
+    static constexpr size_t links_offset = (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+    template <unsigned L>
+    struct sized
+    {
+        alignas(Node) alignas(Link) unsigned char bytes[links_offset + L * sizeof(Link)];
+    };
+    size_t l_size;
+    unsigned top;
+    uint64_t state;
+    Link head[max_level];
+    // three nodes in four have one link, almost all the rest two to four: those come from pools, taller ones from the heap
+    Pool<sized<1>> pool1;
+    Pool<sized<2>> pool2;
+    Pool<sized<3>> pool3;
+    Pool<sized<4>> pool4;
+    static Node* node_of(Link* links)
+    {
+        return std::launder(reinterpret_cast<Node*>(reinterpret_cast<unsigned char*>(links) - links_offset));
+    }
+    static Link* links_of(Node* node)
+    {
+        return reinterpret_cast<Link*>(reinterpret_cast<unsigned char*>(node) + links_offset);
+    }
+    unsigned random_level()
+    {
+        // xorshift64, two zero bits per extra level
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        unsigned level = 1 + __builtin_ctzll(state | (uint64_t(1) << 62)) / 2;
+        return level < max_level ? level : max_level;
+    }
+    void*   allocate(unsigned level)
+    {
+        switch (level)
+        {
+            case 1: return pool1.allocate();
+            case 2: return pool2.allocate();
+            case 3: return pool3.allocate();
+            case 4: return pool4.allocate();
+            default: return ::operator new(links_offset + level * sizeof(Link), std::align_val_t(alignof(sized<1>)));
+        }
+    }
+    void    deallocate(void* p, unsigned level)
+    {
+        switch (level)
+        {
+            case 1: pool1.deallocate(static_cast<sized<1>*>(p)); return;
+            case 2: pool2.deallocate(static_cast<sized<2>*>(p)); return;
+            case 3: pool3.deallocate(static_cast<sized<3>*>(p)); return;
+            case 4: pool4.deallocate(static_cast<sized<4>*>(p)); return;
+            default: ::operator delete(p, std::align_val_t(alignof(sized<1>)));
+        }
+    }
+    Link*   create_node(T item)
+    {
+        unsigned level = random_level();
+        void* p = allocate(level);
+        try
+        {
+            new (p) Node(std::move(item), level);
+        }
+        catch (...)
+        {
+            deallocate(p, level);
+            throw;
+        }
+        return links_of(static_cast<Node*>(p));
+    }
+    void    destroy_node(Link* links)
+    {
+        Node* node = node_of(links);
+        unsigned level = node->level;
+        node->~Node();
+        deallocate(node, level);
+    }
+    // fills update[] with the last node before position index (0 based) on every level, and pos[] with their positions (head is 0)
+    void    find(size_t index, Link** update, size_t* pos)
+    {
+        Link* x = head;
+        size_t at = 0;
+        for (unsigned l = top; l-- > 0;)
+        {
+            while (x[l].next != nullptr && at + x[l].width <= index)
+            {
+                at += x[l].width;
+                x = x[l].next;
+            }
+            update[l] = x;
+            pos[l] = at;
+        }
+    }
+    // unlinks the node following update[] on level 0, widths of links spanning it shrink by one
+    void    unlink(Link** update)
+    {
+        Link* target = update[0][0].next;
+        unsigned level = node_of(target)->level;
+        for (unsigned l = 0; l < top; l++)
+        {
+            if (l < level)
+            {
+                update[l][l].next = target[l].next;
+                update[l][l].width += target[l].width - 1;
+            }
+            else update[l][l].width--;
+        }
+        destroy_node(target);
+        l_size--;
+        while (top > 1 && head[top - 1].next == nullptr) top--;
+    }
+public:
+    skip_list(const skip_list&) = delete;
+    skip_list& operator=(const skip_list&) = delete;
+    bool    empty()
+    {
+        return (l_size == 0);
+    }
+    size_t  size()
+    {
+        return l_size;
+    }
+    void    add(T item)
+    {
+        insert(std::move(item), 0);
+    }
+    void    insert(T item, size_t index)
+    {
+        if (index > l_size) return;
+        Link* links = create_node(std::move(item));
+        unsigned level = node_of(links)->level;
+        // new levels start at the head, spanning the whole list
+        for (; top < level; top++)
+        {
+            head[top].next = nullptr;
+            head[top].width = l_size + 1;
+        }
+        Link* update[max_level];
+        size_t pos[max_level];
+        find(index, update, pos);
+        for (unsigned l = 0; l < top; l++)
+        {
+            if (l < level)
+            {
+                // the new node sits at position index + 1, its link takes over the rest of the old span
+                links[l].next = update[l][l].next;
+                links[l].width = pos[l] + update[l][l].width - index;
+                update[l][l].next = links;
+                update[l][l].width = index + 1 - pos[l];
+            }
+            else update[l][l].width++;
+        }
+        l_size++;
+    }
+    T&      at(size_t index)
+    {
+        if (index >= l_size) throw std::out_of_range("skip_list::at");
+        Link* x = head;
+        size_t reached = 0;
+        for (unsigned l = top; l-- > 0;)
+        {
+            while (x[l].next != nullptr && reached + x[l].width <= index + 1)
+            {
+                reached += x[l].width;
+                x = x[l].next;
+            }
+        }
+        return node_of(x)->data;
+    }
+    T&      operator[](size_t index)
+    {
+        return at(index);
+    }
+    void    remove_value(T value)
+    {
+        size_t index = 0;
+        for (Link* x = head[0].next; x != nullptr; x = x[0].next, index++)
+        {
+            if (node_of(x)->data != value) continue;
+            remove_index(index);
+            return;
+        }
+    }
+    // one pass along the bottom level, remembering the last surviving node on every level
+    void    remove_value_all(T value)
+    {
+        Link* last[max_level];
+        for (unsigned l = 0; l < top; l++) last[l] = head;
+        Link* x = head[0].next;
+        while (x != nullptr)
+        {
+            Link* next = x[0].next;
+            Node* node = node_of(x);
+            if (node->data != value)
+            {
+                for (unsigned l = 0; l < node->level; l++) last[l] = x;
+                x = next;
+                continue;
+            }
+            for (unsigned l = 0; l < top; l++)
+            {
+                if (l < node->level)
+                {
+                    last[l][l].next = x[l].next;
+                    last[l][l].width += x[l].width - 1;
+                }
+                else last[l][l].width--;
+            }
+            destroy_node(x);
+            l_size--;
+            x = next;
+        }
+        while (top > 1 && head[top - 1].next == nullptr) top--;
+    }
+    void    remove_index(size_t index)
+    {
+        if (empty())
+        {
+            std::cout << "empty()" << std::endl;
+            return;
+        }
+        if (index >= l_size)
+        {
+            std::cout << "Out of bounds!" << std::endl;
+            return;
+        }
+        Link* update[max_level];
+        size_t pos[max_level];
+        find(index, update, pos);
+        unlink(update);
+    }
+    void    print()
+    {
+        if (empty()) {
+            std::cout << "is_empty()" << std::endl;
+            return;
+        }
+        for (Link* x = head[0].next; x != nullptr; x = x[0].next)
+        {
+            std::cout << node_of(x)->data;
+            if (x[0].next != nullptr) std::cout << ", ";
+        }
+        std::cout << "." << std::endl;
+    }
+    void    clear()
+    {
+        Link* x = head[0].next;
+        while (x != nullptr)
+        {
+            Link* next = x[0].next;
+            Node* node = node_of(x);
+            if (!std::is_trivially_destructible<T>::value || !Pool<sized<1>>::bulk_release || node->level > 4) destroy_node(x);
+            x = next;
+        }
+        pool1.release();
+        pool2.release();
+        pool3.release();
+        pool4.release();
+        top = 1;
+        head[0].next = nullptr;
+        head[0].width = 1;
+        l_size = 0;
+    }
+    explicit skip_list(uint64_t seed = 0x9e3779b97f4a7c15)
+    {
+        l_size = 0;
+        top = 1;
+        state = seed | 1;
+        head[0].next = nullptr;
+        head[0].width = 1;
+    }
+    ~skip_list()
+    {
+        clear();
+    }
+};
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef     UNROLLED_LIST
+#define     UNROLLED_LIST 1
+
+#include    <iostream>
+#include    <cstdint>
+#include    <cstring>
+#include    <new>
+#include    <type_traits>
+#include    <utility>
+#ifdef      __SSE2__
+#include    <emmintrin.h>
+#endif
+#include    "node_pool.hpp"
+
+// same interface as linked_list, but every node holds up to N elements in a small array
+// traversals touch one node per N elements instead of one per element,
+// and remove_value() compares arithmetic elements 16 bytes at a time with SSE2
+// blocks below half full are merged with their successor, so nodes stay dense
+
+template <class T, size_t N = (sizeof(T) < 60 ? 240 / sizeof(T) : 4), template <class> class Pool = node_pool>
+class unrolled_list
+{
+private:
+    static_assert(N >= 2, "unrolled_list: blocks must hold at least two elements");
+    size_t l_size;
+    struct Block
+    {
+        Block*  next = nullptr;
+        size_t  count = 0;
+        alignas(T) unsigned char storage[N * sizeof(T)];
+        T*      items()
+        {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+    Block* start;
+    Pool<Block> pool;
+    Block*  create_block()
+    {
+        return new (pool.allocate()) Block();
+    }
+    void    destroy_block(Block* block)
+    {
+        T* items = block->items();
+        for (size_t i = 0; i < block->count; i++) items[i].~T();
+        block->~Block();
+        pool.deallocate(block);
+    }
+    // opens a gap at position 'at' of a block that is not full
+    static void shift_up(Block* block, size_t at)
+    {
+        T* items = block->items();
+        if (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(static_cast<void*>(items + at + 1), items + at, (block->count - at) * sizeof(T));
+            return;
+        }
+        if (at == block->count) return;
+        new (items + block->count) T(std::move(items[block->count - 1]));
+        for (size_t i = block->count - 1; i > at; i--) items[i] = std::move(items[i - 1]);
+        items[at].~T();
+    }
+    // closes the gap left by the destroyed element at position 'at'
+    static void shift_down(Block* block, size_t at)
+    {
+        T* items = block->items();
+        if (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(static_cast<void*>(items + at), items + at + 1, (block->count - at - 1) * sizeof(T));
+            return;
+        }
+        if (at + 1 == block->count) return;
+        new (items + at) T(std::move(items[at + 1]));
+        for (size_t i = at + 1; i + 1 < block->count; i++) items[i] = std::move(items[i + 1]);
+        items[block->count - 1].~T();
+    }
+    // moves elements [from, count) of 'block' to the end of 'to'
+    static void move_items(Block* block, size_t from, Block* to)
+    {
+        T* src = block->items();
+        T* dst = to->items();
+        for (size_t i = from; i < block->count; i++)
+        {
+            new (dst + to->count++) T(std::move(src[i]));
+            src[i].~T();
+        }
+        block->count = from;
+    }
+    // full block: the upper half moves to a new block inserted after it
+    void    split(Block* block)
+    {
+        Block* half = create_block();
+        move_items(block, N / 2, half);
+        half->next = block->next;
+        block->next = half;
+    }
+    // after a removal: unlink an empty block, or merge a sparse block with its successor
+    void    settle(Block* block, Block* prev)
+    {
+        if (block->count == 0)
+        {
+            if (prev == nullptr) start = block->next; else prev->next = block->next;
+            destroy_block(block);
+            return;
+        }
+        Block* next = block->next;
+        if (next != nullptr && block->count < N / 2 && block->count + next->count <= N)
+        {
+            move_items(next, 0, block);
+            block->next = next->next;
+            destroy_block(next);
+        }
+    }
+    // position of the first element equal to value in items[0, count), or count
+    static size_t find(const T* items, size_t count, const T& value)
+    {
+        size_t i = 0;
+        #ifdef      __SSE2__
+        if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && (sizeof(T) <= 4 || std::is_floating_point<T>::value))
+        {
+            constexpr size_t lanes = 16 / sizeof(T);
+            for (; i + lanes <= count; i += lanes)
+            {
+                int mask;
+                if constexpr (std::is_same<T, float>::value)
+                {
+                    mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(items + i), _mm_set1_ps(value)));
+                }
+                else if constexpr (std::is_same<T, double>::value)
+                {
+                    mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(items + i), _mm_set1_pd(value)));
+                }
+                else if constexpr (std::is_floating_point<T>::value)
+                {
+                    break;
+                }
+                else
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i));
+                    __m128i eq;
+                    if constexpr (sizeof(T) == 1)      eq = _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(value)));
+                    else if constexpr (sizeof(T) == 2) eq = _mm_cmpeq_epi16(block, _mm_set1_epi16(static_cast<short>(value)));
+                    else                               eq = _mm_cmpeq_epi32(block, _mm_set1_epi32(static_cast<int>(value)));
+                    // one bit per byte, the first set bit belongs to the first matching element
+                    int bytes = _mm_movemask_epi8(eq);
+                    if (bytes != 0) return i + __builtin_ctz(static_cast<unsigned>(bytes)) / sizeof(T);
+                    continue;
+                }
+                if (mask != 0) return i + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+        }
+        #endif
+        for (; i < count; i++) if (items[i] == value) return i;
+        return count;
+    }
+public:
+    unrolled_list(const unrolled_list&) = delete;
+    unrolled_list& operator=(const unrolled_list&) = delete;
+    bool    empty()
+    {
+        return (l_size == 0);
+    }
+    size_t  size()
+    {
+        return l_size;
+    }
+    void    add(T item)
+    {
+        if (start == nullptr || start->count == N)
+        {
+            Block* block = create_block();
+            block->next = start;
+            start = block;
+        }
+        shift_up(start, 0);
+        new (start->items()) T(std::move(item));
+        start->count++;
+        l_size++;
+    }
+    void    insert(T item, size_t index)
+    {
+        if (index > l_size) return;
+        if (index == 0)
+        {
+            add(std::move(item));
+            return;
+        }
+        // the block holding position index - 1, so index == size() appends to the last block
+        Block* current = start;
+        size_t at = index;
+        while (at > current->count)
+        {
+            at -= current->count;
+            current = current->next;
+        }
+        if (current->count == N)
+        {
+            split(current);
+            if (at > current->count)
+            {
+                at -= current->count;
+                current = current->next;
+            }
+        }
+        shift_up(current, at);
+        new (current->items() + at) T(std::move(item));
+        current->count++;
+        l_size++;
+    }
+    void    remove_value(T value)
+    {
+        Block* prev = nullptr;
+        for (Block* current = start; current != nullptr; prev = current, current = current->next)
+        {
+            size_t at = find(current->items(), current->count, value);
+            if (at == current->count) continue;
+            current->items()[at].~T();
+            shift_down(current, at);
+            current->count--;
+            l_size--;
+            settle(current, prev);
+            return;
+        }
+    }
+    void    remove_value_all(T value)
+    {
+        Block* prev = nullptr;
+        Block* current = start;
+        while (current != nullptr)
+        {
+            T* items = current->items();
+            size_t keep = find(items, current->count, value);
+            if (keep == current->count)
+            {
+                prev = current;
+                current = current->next;
+                continue;
+            }
+            // stable compaction from the first match onwards
+            for (size_t i = keep; i < current->count; i++)
+            {
+                if (items[i] == value) continue;
+                items[keep++] = std::move(items[i]);
+            }
+            for (size_t i = keep; i < current->count; i++) items[i].~T();
+            l_size -= current->count - keep;
+            current->count = keep;
+            Block* next = current->next;
+            settle(current, prev);
+            if (keep == 0)
+            {
+                current = next;
+                continue;
+            }
+            // merged with its successor: scan the block again, the moved elements have not been looked at
+            if (current->next != next) continue;
+            prev = current;
+            current = next;
+        }
+    }
+    void    remove_index(size_t index)
+    {
+        if (empty())
+        {
+            std::cout << "empty()" << std::endl;
+            return;
+        }
+        if (index >= l_size)
+        {
+            std::cout << "Out of bounds!" << std::endl;
+            return;
+        }
+        Block* prev = nullptr;
+        Block* current = start;
+        while (index >= current->count)
+        {
+            index -= current->count;
+            prev = current;
+            current = current->next;
+        }
+        current->items()[index].~T();
+        shift_down(current, index);
+        current->count--;
+        l_size--;
+        settle(current, prev);
+    }
+    void    print()
+    {
+        if (empty()) {
+            std::cout << "is_empty()" << std::endl;
+            return;
+        }
+        for (Block* current = start; current != nullptr; current = current->next)
+        {
+            T* items = current->items();
+            for (size_t i = 0; i < current->count; i++)
+            {
+                std::cout << items[i];
+                if (i + 1 < current->count || current->next != nullptr) std::cout << ", ";
+            }
+        }
+        std::cout << "." << std::endl;
+    }
+    void    clear()
+    {
+        Block* current = start;
+        while (current != nullptr)
+        {
+            Block* next = current->next;
+            if (!std::is_trivially_destructible<T>::value || !Pool<Block>::bulk_release) destroy_block(current);
+            current = next;
+        }
+        pool.release();
+        start = nullptr;
+        l_size = 0;
+    }
+    unrolled_list()
+    {
+        l_size = 0;
+        start = nullptr;
+    }
+    ~unrolled_list()
+    {
+        clear();
+    }
+};
+
+#endif